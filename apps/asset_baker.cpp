@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "cinder/Text.h"
+#include "asset_pack.h"
+#include "game_engine.h"
+#include "reachability.h"
+
+using flappybird::AssetPack;
+using flappybird::AssetPackWriter;
+using flappybird::BakedGlyph;
+using flappybird::GameEngine;
+using flappybird::ReachabilityTable;
+using std::string;
+using std::vector;
+
+// atlases are this wide and grow downwards, shelf by shelf
+static const uint32_t kAtlasWidth = 512;
+// empty texels kept around every glyph so linear filtering doesn't bleed neighbours in
+static const uint32_t kGlyphPadding = 1;
+
+// a rendered glyph before it has a place in the atlas
+struct GlyphImage {
+    ci::Surface8u surface_;
+    float advance_;
+};
+
+// renders every printable character of a font the same way drawStringCentered would and packs them into one atlas
+static void BakeFont(const string &name, float size, AssetPackWriter &writer) {
+    ci::Font font(name, size);
+    vector<GlyphImage> images;
+    float baseline_offset = 0;
+    for (uint32_t code = flappybird::kFirstBakedChar; code <= flappybird::kLastBakedChar; code++) {
+        GlyphImage image;
+        image.surface_ = ci::renderString(string(1, static_cast<char>(code)), font, ci::ColorA(1, 1, 1, 1),
+                                          &baseline_offset);
+        // a space renders nothing, it still has to move the pen
+        image.advance_ = image.surface_.getWidth() > 0 ? image.surface_.getWidth() : size / 4;
+        images.push_back(image);
+    }
+
+    // shelf packing: glyphs go left to right and a new shelf starts under the tallest glyph of the last one
+    uint32_t atlas_width = kAtlasWidth;
+    for (const GlyphImage &image : images) {
+        atlas_width = std::max(atlas_width, static_cast<uint32_t>(image.surface_.getWidth()) + 2 * kGlyphPadding);
+    }
+    vector<BakedGlyph> glyphs;
+    uint32_t x = 0;
+    uint32_t y = 0;
+    uint32_t shelf_height = 0;
+    for (const GlyphImage &image : images) {
+        uint32_t width = image.surface_.getWidth() + 2 * kGlyphPadding;
+        uint32_t height = image.surface_.getHeight() + 2 * kGlyphPadding;
+        if (x + width > atlas_width) {
+            x = 0;
+            y += shelf_height;
+            shelf_height = 0;
+        }
+        BakedGlyph glyph;
+        glyph.atlas_x_ = x + kGlyphPadding;
+        glyph.atlas_y_ = y + kGlyphPadding;
+        glyph.width_ = image.surface_.getWidth();
+        glyph.height_ = image.surface_.getHeight();
+        glyph.advance_ = image.advance_;
+        glyphs.push_back(glyph);
+        x += width;
+        shelf_height = std::max(shelf_height, height);
+    }
+    uint32_t atlas_height = y + shelf_height;
+
+    // the text is rendered white, so the alpha of a texel is all the atlas needs
+    vector<uint8_t> atlas(atlas_width * atlas_height, 0);
+    for (size_t i = 0; i < images.size(); i++) {
+        const ci::Surface8u &surface = images[i].surface_;
+        for (int row = 0; row < surface.getHeight(); row++) {
+            for (int column = 0; column < surface.getWidth(); column++) {
+                size_t texel = (static_cast<size_t>(glyphs[i].atlas_y_) + row) * atlas_width +
+                               static_cast<size_t>(glyphs[i].atlas_x_) + column;
+                atlas[texel] = surface.getPixel(glm::ivec2(column, row)).a;
+            }
+        }
+    }
+    writer.AddFont(name, size, baseline_offset, glyphs, atlas_width, atlas_height, atlas);
+    std::cout << name << " " << size << ": " << atlas_width << "x" << atlas_height << " atlas" << std::endl;
+}
+
+// runs the same search reachability-tool reports on, so the game starts with the table instead of building it
+static void BakeReachability(const string &name, const flappybird::FlightPhysics &physics, AssetPackWriter &writer) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    ReachabilityTable table(physics);
+    table.Bake(writer);
+    double build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name << " reachability table: built in " << build_ms << " ms" << std::endl;
+}
+
+// Bakes the glyph atlases of every font size the game draws with and the reachability tables of the random modes into
+// an asset pack the game maps at startup
+// Usage: asset-baker <output pack>
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        std::cerr << "usage: asset-baker <output pack>" << std::endl;
+        return 2;
+    }
+    string path = argv[1];
+    GameEngine game_engine;
+    AssetPackWriter writer;
+    for (float size : game_engine.GetFontSizes()) {
+        BakeFont(game_engine.GetFontName(), size, writer);
+    }
+    BakeReachability("normal", game_engine.GetFlightPhysics(GameEngine::Normal), writer);
+    BakeReachability("challenge", game_engine.GetFlightPhysics(GameEngine::Challenge), writer);
+    if (!writer.Write(path)) {
+        std::cerr << "Could not write " << path << std::endl;
+        return 1;
+    }
+
+    // opening the pack the way the game does catches a broken pack at build time instead of at launch
+    AssetPack pack;
+    string error;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (!pack.Open(path, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    double open_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Wrote " << path << ", opens in " << open_us << " us" << std::endl;
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include "course_file.h"
+
+using flappybird::CourseFile;
+using flappybird::CoursePipe;
+using flappybird::CourseWriter;
+using std::string;
+
+// whether a line of a text course holds nothing to convert
+static bool IsBlankOrComment(const string &line) {
+    size_t first = line.find_first_not_of(" \t\r");
+    return first == string::npos || line[first] == '#';
+}
+
+// converts a text course into a course file, stopping at the first line that isn't a valid pipe
+static int Convert(const string &input_path, const string &output_path) {
+    std::ifstream input(input_path);
+    if (!input) {
+        std::cerr << "Could not open " << input_path << std::endl;
+        return 1;
+    }
+    CourseWriter writer;
+    if (!writer.Open(output_path)) {
+        std::cerr << "Could not create " << output_path << std::endl;
+        return 1;
+    }
+    string line;
+    size_t line_number = 0;
+    while (std::getline(input, line)) {
+        line_number++;
+        if (IsBlankOrComment(line)) {
+            continue;
+        }
+        CoursePipe pipe;
+        string error = "expected: spacing gap_bottom gap_size width speed color";
+        if (!ParseCoursePipe(line, pipe) || !ValidateCoursePipe(pipe, error)) {
+            std::cerr << input_path << ":" << line_number << ": " << error << std::endl;
+            return 1;
+        }
+        writer.Write(pipe);
+    }
+    if (!writer.Finish()) {
+        std::cerr << "Could not write " << output_path << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// checks the header and every pipe of a course file, reading it the same way the game does
+static int Validate(const string &path) {
+    CourseFile course;
+    string error;
+    if (!course.Open(path, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    size_t num_invalid = 0;
+    for (size_t i = 0; i < course.GetPipeCount(); i++) {
+        if (!ValidateCoursePipe(course.GetPipe(i), error)) {
+            if (num_invalid++ < 20) {
+                std::cerr << path << ": pipe " << i << ": " << error << std::endl;
+            }
+        }
+        course.ReleaseBefore(i);
+    }
+    std::cout << path << ": " << course.GetPipeCount() << " pipes, " << num_invalid << " invalid" << std::endl;
+    return num_invalid == 0 ? 0 : 1;
+}
+
+// writes a random but valid course, used to try out very long courses
+static int Generate(size_t num_pipes, const string &path, unsigned seed) {
+    std::mt19937 random_engine(seed);
+    std::uniform_real_distribution<float> unit(0, 1);
+    CourseWriter writer;
+    if (!writer.Open(path)) {
+        std::cerr << "Could not create " << path << std::endl;
+        return 1;
+    }
+    for (size_t i = 0; i < num_pipes; i++) {
+        CoursePipe pipe;
+        pipe.width_ = 30 + 40 * unit(random_engine);
+        pipe.spacing_ = 180 + 160 * unit(random_engine);
+        pipe.gap_size_ = 90 + 60 * unit(random_engine);
+        pipe.gap_bottom_ = pipe.gap_size_ + 60 + (flappybird::kCourseFieldHeight - pipe.gap_size_ - 120) *
+                           unit(random_engine);
+        pipe.speed_ = 2 + 2 * unit(random_engine);
+        pipe.color_ = random_engine() & 0xffffff;
+        writer.Write(pipe);
+    }
+    if (!writer.Finish()) {
+        std::cerr << "Could not write " << path << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Converts, validates and generates authored course files
+// Usage: course-tool convert <course.txt> <course.bin>
+//        course-tool validate <course.bin>
+//        course-tool generate <number of pipes> <course.bin> [seed]
+int main(int argc, char **argv) {
+    string command = argc > 1 ? argv[1] : "";
+    if (command == "convert" && argc == 4) {
+        return Convert(argv[2], argv[3]);
+    }
+    if (command == "validate" && argc == 3) {
+        return Validate(argv[2]);
+    }
+    if (command == "generate" && (argc == 4 || argc == 5)) {
+        unsigned seed = argc == 5 ? std::strtoul(argv[4], nullptr, 10) : 0;
+        return Generate(std::strtoull(argv[2], nullptr, 10), argv[3], seed);
+    }
+    std::cerr << "Usage: course-tool convert <course.txt> <course.bin>" << std::endl
+              << "       course-tool validate <course.bin>" << std::endl
+              << "       course-tool generate <number of pipes> <course.bin> [seed]" << std::endl;
+    return 2;
+}
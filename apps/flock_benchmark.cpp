@@ -0,0 +1,57 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include "game_engine.h"
+
+using flappybird::Flock;
+using flappybird::GameEngine;
+using flappybird::GapFollower;
+using std::chrono::steady_clock;
+
+// Headless benchmark for multi-bird runs, flies a flock of gap following bots for a minute of game time and times
+// every tick including the snapshot the render thread would get
+// Usage: flock-benchmark [birds] [mode: normal, storm]
+// Exits with 1 if the average tick doesn't fit in one 60 Hz frame
+int main(int argc, char **argv) {
+    size_t num_birds = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+    GameEngine::GameMode game_mode = argc > 2 && std::string(argv[2]) == "storm" ? GameEngine::PipeStorm
+                                                                                  : GameEngine::Normal;
+    const size_t kTicks = 3600;
+    const double kBudgetMilliseconds = 1000.0 / 60;
+
+    GameEngine game_engine;
+    // a spread of margins so the bots don't all fly the same line
+    for (size_t i = 0; i < num_birds; i++) {
+        game_engine.AddFlockBird(Flock::kNoKey, std::make_shared<GapFollower>(5 + 40.0f * i / num_birds),
+                                 Color("white"));
+    }
+    game_engine.StartRun(1, game_mode);
+    std::unique_ptr<GameEngine::Snapshot> snapshot(new GameEngine::Snapshot());
+
+    double total_milliseconds = 0;
+    double worst_milliseconds = 0;
+    size_t num_ticks = 0;
+    // the scroll would stop once every bot is down, the run is restarted so every tick has birds to move
+    for (; num_ticks < kTicks; num_ticks++) {
+        if (game_engine.GetGameState() != GameEngine::GameScreen) {
+            game_engine.StartRun(static_cast<unsigned>(num_ticks), game_mode);
+        }
+        steady_clock::time_point start = steady_clock::now();
+        game_engine.AdvanceOneFrame();
+        game_engine.WriteSnapshot(*snapshot);
+        double milliseconds = std::chrono::duration<double, std::milli>(steady_clock::now() - start).count();
+        total_milliseconds += milliseconds;
+        if (milliseconds > worst_milliseconds) {
+            worst_milliseconds = milliseconds;
+        }
+    }
+
+    double average_milliseconds = total_milliseconds / num_ticks;
+    std::cout << "birds: " << num_birds << "\n"
+              << "still flying: " << game_engine.GetFlock().GetFlyingCount() << "\n"
+              << "best score: " << game_engine.GetScore() << "\n"
+              << "average tick: " << average_milliseconds << " ms\n"
+              << "worst tick: " << worst_milliseconds << " ms" << std::endl;
+    return average_milliseconds <= kBudgetMilliseconds ? 0 : 1;
+}
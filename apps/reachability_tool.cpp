@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include "game_engine.h"
+#include "reachability.h"
+
+using flappybird::FlightPhysics;
+using flappybird::GameEngine;
+using flappybird::ReachabilityTable;
+using std::string;
+
+// builds one mode's table and reports how much of the old uniform spawning it rules out
+static void Report(const string &name, const FlightPhysics &physics, bool dump) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    ReachabilityTable table(physics);
+    double build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    size_t num_gaps = static_cast<size_t>(physics.max_gap_bottom_ - physics.min_gap_bottom_ + 1);
+    size_t num_reachable = 0;
+    int widest_climb = 0;
+    int widest_drop = 0;
+    for (int from = physics.min_gap_bottom_; from <= physics.max_gap_bottom_; from++) {
+        for (int to = physics.min_gap_bottom_; to <= physics.max_gap_bottom_; to++) {
+            num_reachable += table.IsReachable(from, to);
+        }
+        // heights grow downwards, a climb is to a smaller lower edge
+        widest_climb = std::max(widest_climb, from - table.GetMinNext(from));
+        widest_drop = std::max(widest_drop, table.GetMaxNext(from) - from);
+        if (dump) {
+            std::cout << name << " " << from << ": " << table.GetMinNext(from) << " to " << table.GetMaxNext(from)
+                      << "\n";
+        }
+    }
+    std::cout << name << ": built in " << build_ms << " ms, " << num_reachable << " of " << num_gaps * num_gaps
+              << " transitions reachable (" << 100.0 * num_reachable / (num_gaps * num_gaps) << "%), climbs up to "
+              << widest_climb << " px, drops up to " << widest_drop << " px, " << table.GetUnusedTransitions()
+              << " reachable transitions outside the spawn ranges" << std::endl;
+}
+
+// Builds the reachability tables the spawner draws gaps from and summarizes them
+// Usage: reachability-tool [normal|challenge] [--dump]
+// --dump also prints the range of next gaps every gap can be followed by
+int main(int argc, char **argv) {
+    string mode;
+    bool dump = false;
+    for (int i = 1; i < argc; i++) {
+        string argument = argv[i];
+        if (argument == "--dump") {
+            dump = true;
+        } else if (argument == "normal" || argument == "challenge") {
+            mode = argument;
+        } else {
+            std::cerr << "usage: reachability-tool [normal|challenge] [--dump]" << std::endl;
+            return 2;
+        }
+    }
+    GameEngine game_engine;
+    if (mode != "challenge") {
+        Report("normal", game_engine.GetFlightPhysics(GameEngine::Normal), dump);
+    }
+    if (mode != "normal") {
+        Report("challenge", game_engine.GetFlightPhysics(GameEngine::Challenge), dump);
+    }
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include "score_verifier.h"
+
+using flappybird::ScoreVerifier;
+using flappybird::Submission;
+using flappybird::SubmissionQueue;
+using flappybird::Verdict;
+using std::chrono::steady_clock;
+
+// how many parsed submissions may wait for a worker before the reader blocks
+static const size_t kQueueCapacity = 4096;
+
+// pushes every submission in a stream, ids are <source>:<line number>
+static void ReadSubmissions(std::istream &input, const string &source, SubmissionQueue &queue) {
+    string line;
+    size_t line_number = 0;
+    while (std::getline(input, line)) {
+        line_number++;
+        Submission submission;
+        if (ParseSubmission(line, submission)) {
+            submission.id_ = source + ":" + std::to_string(line_number);
+            queue.Push(std::move(submission));
+        }
+    }
+}
+
+// pushes the submissions of a file, or of every file in a directory
+static void ReadPath(const string &path, SubmissionQueue &queue) {
+    DIR *directory = opendir(path.c_str());
+    if (directory == nullptr) {
+        std::ifstream file(path);
+        if (!file) {
+            std::cerr << "Could not open " << path << std::endl;
+        }
+        ReadSubmissions(file, path, queue);
+        return;
+    }
+    while (dirent *entry = readdir(directory)) {
+        string name = entry->d_name;
+        if (name != "." && name != "..") {
+            ReadPath(path + "/" + name, queue);
+        }
+    }
+    closedir(directory);
+}
+
+// Headless verifier that replays submitted runs and accepts or rejects their claimed scores
+// Usage: score-verifier [--threads N] [file or directory]... reads stdin when no paths are given
+int main(int argc, char **argv) {
+    size_t num_threads = 0;
+    vector<string> paths;
+    for (int i = 1; i < argc; i++) {
+        string argument = argv[i];
+        if (argument == "--threads" && i + 1 < argc) {
+            num_threads = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            paths.push_back(argument);
+        }
+    }
+
+    SubmissionQueue queue(kQueueCapacity);
+    std::thread reader([&queue, &paths] {
+        if (paths.empty()) {
+            ReadSubmissions(std::cin, "stdin", queue);
+        }
+        for (const string &path : paths) {
+            ReadPath(path, queue);
+        }
+        queue.Close();
+    });
+
+    ScoreVerifier verifier(num_threads);
+    std::mutex output_mutex;
+    std::atomic<size_t> accepted(0);
+    std::atomic<size_t> rejected(0);
+    steady_clock::time_point start = steady_clock::now();
+    verifier.Run(queue, [&](const Submission &submission, const Verdict &verdict) {
+        (verdict.accepted_ ? accepted : rejected)++;
+        std::lock_guard<std::mutex> lock(output_mutex);
+        if (verdict.accepted_) {
+            std::cout << submission.id_ << " ACCEPT " << verdict.simulated_score_ << "\n";
+        } else {
+            std::cout << submission.id_ << " REJECT claimed " << submission.claimed_score_ << " replayed " 
+                      << verdict.simulated_score_ << " diverged at frame " << verdict.divergence_frame_ << "\n";
+        }
+    });
+    reader.join();
+    double seconds = std::chrono::duration<double>(steady_clock::now() - start).count();
+
+    size_t total = accepted + rejected;
+    std::cerr << total << " runs verified on " << verifier.GetWorkerCount() << " threads in " << seconds << " s ("
+              << (seconds > 0 ? total / seconds : 0) << " runs/s), " << accepted << " accepted, " << rejected 
+              << " rejected" << std::endl;
+    return 0;
+}
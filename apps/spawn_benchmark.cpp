@@ -0,0 +1,62 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "game_engine.h"
+#include "reachability.h"
+
+using flappybird::FlightPhysics;
+using flappybird::GameEngine;
+using flappybird::PickGapBottom;
+using flappybird::ReachabilityTable;
+using std::chrono::steady_clock;
+
+// Headless benchmark for gap spawning, times picking gaps the way the spawner did before the reachability tables
+// against picking them through a table, in the mode where the table rules out the most transitions
+// Usage: spawn-benchmark [spawns]
+// Exits with 1 if spawning through the table costs noticeably more
+int main(int argc, char **argv) {
+    size_t num_spawns = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+    const double kAllowedSlowdown = 1.5;
+    // the spawn range of every gap after the first, the same numbers UpdateObstacleVector uses
+    const float kLowest = 150;
+    const size_t kRange = 353;
+
+    GameEngine game_engine;
+    FlightPhysics physics = game_engine.GetFlightPhysics(GameEngine::Challenge);
+    steady_clock::time_point build_start = steady_clock::now();
+    const ReachabilityTable &table = ReachabilityTable::Get(physics);
+    double build_ms = std::chrono::duration<double, std::milli>(steady_clock::now() - build_start).count();
+
+    // spawns are dozens of ticks apart in a run, so both spawners get the same previous gaps from a list instead of
+    // each pick waiting on the one before it, the picks are summed so the loops can't be optimized away
+    const size_t kNumPrevious = 4096;
+    std::mt19937 random(1);
+    std::vector<float> previous(kNumPrevious);
+    for (float &gap_bottom : previous) {
+        gap_bottom = PickGapBottom(nullptr, 0, kLowest, kRange, random);
+    }
+
+    // without a table PickGapBottom is the old spawn formula, so both loops pay for the same call and the
+    // difference is what the table lookup adds
+    double uniform_sum = 0;
+    steady_clock::time_point start = steady_clock::now();
+    for (size_t i = 0; i < num_spawns; i++) {
+        uniform_sum += PickGapBottom(nullptr, previous[i % kNumPrevious], kLowest, kRange, random);
+    }
+    double uniform_ns = std::chrono::duration<double, std::nano>(steady_clock::now() - start).count() / num_spawns;
+
+    double table_sum = 0;
+    start = steady_clock::now();
+    for (size_t i = 0; i < num_spawns; i++) {
+        table_sum += PickGapBottom(&table, previous[i % kNumPrevious], kLowest, kRange, random);
+    }
+    double table_ns = std::chrono::duration<double, std::nano>(steady_clock::now() - start).count() / num_spawns;
+
+    std::cout << "spawns: " << num_spawns << "\n"
+              << "table built in: " << build_ms << " ms\n"
+              << "uniform spawn: " << uniform_ns << " ns (average gap " << uniform_sum / num_spawns << ")\n"
+              << "table spawn: " << table_ns << " ns (average gap " << table_sum / num_spawns << ")" << std::endl;
+    return table_ns <= uniform_ns * kAllowedSlowdown ? 0 : 1;
+}
@@ -0,0 +1,63 @@
+#include <arpa/inet.h>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+#include "spectator_state.h"
+
+using flappybird::DecodeSpectatorFrame;
+using flappybird::SpectatorState;
+
+// Headless spectator client, reconstructs the streamed game state and prints one line per received tick
+// Usage: spectator-viewer <port> [number of ticks to print before exiting]
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <port> [ticks]" << std::endl;
+        return 1;
+    }
+    long ticks_left = argc > 2 ? std::atol(argv[2]) : -1;
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(std::atoi(argv[1])));
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        std::cerr << "Could not connect to port " << argv[1] << std::endl;
+        return 1;
+    }
+
+    SpectatorState state;
+    uint32_t tick = 0;
+    std::vector<uint8_t> received;
+    uint8_t buffer[4096];
+    while (ticks_left != 0) {
+        ssize_t size = recv(fd, buffer, sizeof(buffer), 0);
+        if (size <= 0) {
+            break;
+        }
+        received.insert(received.end(), buffer, buffer + size);
+        size_t offset = 0;
+        size_t frame_size;
+        while (ticks_left != 0 &&
+               (frame_size = DecodeSpectatorFrame(received.data() + offset, received.size() - offset, state, tick))) {
+            offset += frame_size;
+            std::cout << "tick " << tick << " state " << state.game_state_ << " score " << state.score_
+                      << " bird " << state.bird_x_ << "," << state.bird_y_ << " velocity " << state.bird_velocity_;
+            for (uint32_t i = 0; i < state.num_obstacles_ && i < SpectatorState::kMaxObstacles; i++) {
+                std::cout << " [" << state.obstacles_[i].x_ << " " << state.obstacles_[i].gap_top_ << " "
+                          << state.obstacles_[i].gap_bottom_ << "]";
+            }
+            std::cout << "\n";
+            if (ticks_left > 0) {
+                ticks_left--;
+            }
+        }
+        received.erase(received.begin(), received.begin() + offset);
+    }
+    close(fd);
+    return 0;
+}
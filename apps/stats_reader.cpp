@@ -0,0 +1,148 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include "session_stats.h"
+#if defined(__linux__)
+#include <dirent.h>
+#include <signal.h>
+#endif
+
+using flappybird::SessionStats;
+using flappybird::StatsReader;
+using std::chrono::steady_clock;
+using std::string;
+
+// one monitored game process and what was sampled from it during the current second
+struct Session {
+    StatsReader reader_;
+    SessionStats latest_;
+    size_t samples_ = 0;
+    size_t failed_reads_ = 0;
+};
+
+static const char *kGameStateNames[] = {"start", "playing", "game over", "leaderboard", "customize"};
+static const char *kGameModeNames[] = {"normal", "challenge", "storm", "course"};
+
+// the stats segments of running games, found by listing /dev/shm where Linux keeps POSIX shared memory
+static std::set<string> FindSegments() {
+    std::set<string> names;
+#if defined(__linux__)
+    string prefix = flappybird::kStatsNamePrefix + 1;
+    DIR *directory = opendir("/dev/shm");
+    if (directory == nullptr) {
+        return names;
+    }
+    while (dirent *entry = readdir(directory)) {
+        string name = entry->d_name;
+        // segments of processes that crashed are never unlinked, so only live pids are picked up
+        if (name.compare(0, prefix.size(), prefix) == 0 &&
+            kill(static_cast<pid_t>(std::strtoul(name.c_str() + prefix.size(), nullptr, 10)), 0) == 0) {
+            names.insert("/" + name);
+        }
+    }
+    closedir(directory);
+#endif
+    return names;
+}
+
+static void PrintSessions(const std::map<string, Session> &sessions, double read_ns) {
+    std::printf("%-22s %-11s %-9s %6s %5s %7s %9s %9s %9s %9s %7s %8s %7s %6s\n", "session", "state", "mode",
+                "score", "pipes", "tick/s", "p50 us", "p90 us", "p99 us", "max us", "deaths", "deaths/m",
+                "samples", "failed");
+    for (const std::pair<const string, Session> &entry : sessions) {
+        const SessionStats &stats = entry.second.latest_;
+        std::printf("%-22s %-11s %-9s %6u %5u %7.1f %9.1f %9.1f %9.1f %9.1f %7u %8.0f %7zu %6zu\n",
+                    entry.first.c_str(), stats.game_state_ < 5 ? kGameStateNames[stats.game_state_] : "?",
+                    stats.game_mode_ < 4 ? kGameModeNames[stats.game_mode_] : "?", stats.score_,
+                    stats.obstacle_count_, stats.ticks_per_second_, stats.frame_time_p50_us_,
+                    stats.frame_time_p90_us_, stats.frame_time_p99_us_, stats.frame_time_max_us_, stats.deaths_,
+                    stats.deaths_per_minute_, entry.second.samples_, entry.second.failed_reads_);
+    }
+    std::printf("%zu sessions, %.0f ns per read\n\n", sessions.size(), read_ns);
+    std::fflush(stdout);
+}
+
+// Samples the live stats of running games and prints a summary of every session once a second
+// Usage: stats-reader [--hz N] [--seconds N] [segment name]... watches every running game when no names are given
+int main(int argc, char **argv) {
+    double hz = 1000;
+    double seconds = 0;
+    std::set<string> fixed_names;
+    for (int i = 1; i < argc; i++) {
+        string argument = argv[i];
+        if (argument == "--hz" && i + 1 < argc) {
+            hz = std::atof(argv[++i]);
+        } else if (argument == "--seconds" && i + 1 < argc) {
+            seconds = std::atof(argv[++i]);
+        } else {
+            fixed_names.insert(argument);
+        }
+    }
+    if (hz <= 0) {
+        std::cerr << "--hz must be positive" << std::endl;
+        return 2;
+    }
+
+    std::map<string, Session> sessions;
+    steady_clock::duration period = std::chrono::duration_cast<steady_clock::duration>(
+            std::chrono::duration<double>(1 / hz));
+    steady_clock::time_point start = steady_clock::now();
+    steady_clock::time_point next_sample = start;
+    steady_clock::time_point next_report = start;
+    steady_clock::duration read_time(0);
+    size_t num_reads = 0;
+    while (seconds <= 0 || steady_clock::now() - start < std::chrono::duration<double>(seconds)) {
+        steady_clock::time_point now = steady_clock::now();
+        if (now >= next_report) {
+            if (next_report != start) {
+                PrintSessions(sessions, num_reads == 0 ? 0 :
+                              std::chrono::duration<double, std::nano>(read_time).count() / num_reads);
+            }
+            // sessions are looked up once a second, games that quit drop out and new ones are picked up
+            std::set<string> names = fixed_names.empty() ? FindSegments() : fixed_names;
+            for (std::map<string, Session>::iterator it = sessions.begin(); it != sessions.end();) {
+                it = names.count(it->first) == 0 ? sessions.erase(it) : std::next(it);
+            }
+            for (const string &name : names) {
+                if (sessions.count(name) == 0) {
+                    Session session;
+                    if (session.reader_.Open(name)) {
+                        sessions.emplace(name, std::move(session));
+                    }
+                }
+            }
+            for (std::pair<const string, Session> &entry : sessions) {
+                entry.second.samples_ = 0;
+                entry.second.failed_reads_ = 0;
+            }
+            read_time = steady_clock::duration(0);
+            num_reads = 0;
+            next_report += std::chrono::seconds(1);
+        }
+
+        steady_clock::time_point read_start = steady_clock::now();
+        for (std::pair<const string, Session> &entry : sessions) {
+            Session &session = entry.second;
+            if (session.reader_.Read(session.latest_)) {
+                session.samples_++;
+            } else {
+                session.failed_reads_++;
+            }
+        }
+        read_time += steady_clock::now() - read_start;
+        num_reads += sessions.size();
+
+        next_sample += period;
+        if (next_sample < now) {
+            next_sample = now;
+        }
+        std::this_thread::sleep_until(next_sample);
+    }
+    return 0;
+}
@@ -0,0 +1,186 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "reachability.h"
+
+namespace flappybird {
+/**
+ * Asset packs are built once by the asset baker and memory mapped by the game, which uses the data in place
+ * A pack is a header, a table of sections and the sections themselves, each starting on a kAssetAlignment boundary
+ * so the structs in them can be read straight out of the mapping
+ * Every word is in host byte order, packs are baked on the machine that builds the game
+ */
+struct AssetPackHeader {
+    char magic_[8];
+    uint32_t version_;
+    uint32_t section_count_;
+};
+
+struct AssetSection {
+    uint32_t kind_;
+    // number of records in the section, the size in bytes for blobs
+    uint32_t count_;
+    uint64_t offset_;
+    uint64_t size_;
+};
+
+// new kinds of assets get a new section kind, readers skip kinds they don't know
+enum AssetSectionKind : uint32_t {
+    FontSection = 1,
+    GlyphSection = 2,
+    PixelSection = 3,
+    ReachabilitySection = 4,
+    ReachableBitsSection = 5,
+    NextRangeSection = 6
+};
+
+/**
+ * A font baked at one size, its glyphs are glyph_count_ consecutive entries of the glyph section starting at
+ * first_glyph_ for the characters starting at first_char_, and its atlas is an 8 bit coverage image in the pixel
+ * section
+ */
+struct BakedFont {
+    char name_[32];
+    float size_;
+    // how far above the draw position the tops of the glyph images sit
+    float baseline_offset_;
+    uint32_t first_char_;
+    uint32_t first_glyph_;
+    uint32_t glyph_count_;
+    uint32_t atlas_width_;
+    uint32_t atlas_height_;
+    uint32_t pixel_offset_;
+};
+
+/**
+ * Where a glyph image sits in its font's atlas and how far the pen moves after drawing it, in pixels
+ */
+struct BakedGlyph {
+    float atlas_x_;
+    float atlas_y_;
+    float width_;
+    float height_;
+    float advance_;
+};
+
+/**
+ * A reachability table baked for one set of physics, its rows are word_count_ consecutive words of the reachable bits
+ * section starting at first_word_ and its spawn ranges range_count_ consecutive entries of the next range section
+ * starting at first_range_, laid out the way ReachabilityTable keeps them
+ */
+struct BakedReachability {
+    FlightPhysics physics_;
+    uint32_t first_word_;
+    uint32_t word_count_;
+    uint32_t first_range_;
+    uint32_t range_count_;
+    uint32_t unused_transitions_;
+};
+
+static const char kAssetPackMagic[8] = {'F', 'B', 'A', 'S', 'S', 'E', 'T', 'S'};
+static const uint32_t kAssetPackVersion = 1;
+static const size_t kAssetAlignment = 64;
+// the printable ASCII range every baked font covers
+static const uint32_t kFirstBakedChar = 32;
+static const uint32_t kLastBakedChar = 126;
+
+/**
+ * Read only view of a baked asset pack, nothing is copied out of the mapping
+ */
+class AssetPack {
+  public:
+    AssetPack() = default;
+    ~AssetPack();
+    AssetPack(const AssetPack &) = delete;
+    AssetPack &operator=(const AssetPack &) = delete;
+
+    /**
+     * Maps a pack and checks its header and section table
+     * @param path
+     * @param error set to the reason when the pack can't be used
+     * @return whether the pack is ready to read
+     */
+    bool Open(const std::string &path, std::string &error);
+
+    void Close();
+    bool IsOpen() const;
+
+    /**
+     * Finds the font baked for a name and size
+     * @return nullptr if the pack has no such font
+     */
+    const BakedFont *FindFont(const std::string &name, float size) const;
+
+    /**
+     * The glyph of a character in a font, nullptr for characters the font doesn't cover
+     */
+    const BakedGlyph *GetGlyph(const BakedFont &font, char character) const;
+
+    /**
+     * The first row of a font's atlas, rows are atlas_width_ bytes apart
+     */
+    const uint8_t *GetAtlas(const BakedFont &font) const;
+
+    /**
+     * The baked reachability tables, index runs from 0 to GetReachabilityCount() - 1
+     */
+    size_t GetReachabilityCount() const;
+    const BakedReachability &GetReachability(size_t index) const;
+
+    /**
+     * The first reachable bits word and the first spawn range entry of a baked table
+     */
+    const uint64_t *GetReachableBits(const BakedReachability &table) const;
+    const int16_t *GetNextRanges(const BakedReachability &table) const;
+
+  private:
+    void *mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+    const BakedFont *fonts_ = nullptr;
+    size_t font_count_ = 0;
+    const BakedGlyph *glyphs_ = nullptr;
+    size_t glyph_count_ = 0;
+    const uint8_t *pixels_ = nullptr;
+    size_t pixel_count_ = 0;
+    const BakedReachability *reachability_ = nullptr;
+    size_t reachability_count_ = 0;
+    const uint64_t *reachable_bits_ = nullptr;
+    size_t reachable_bit_count_ = 0;
+    const int16_t *next_ranges_ = nullptr;
+    size_t next_range_count_ = 0;
+};
+
+/**
+ * Builds a pack in memory and writes it out in one go, used by the asset baker
+ */
+class AssetPackWriter {
+  public:
+    /**
+     * Adds a font, glyphs are the glyphs for the characters kFirstBakedChar to kLastBakedChar in order and atlas
+     * holds atlas_width * atlas_height coverage bytes
+     */
+    void AddFont(const std::string &name, float size, float baseline_offset, const std::vector<BakedGlyph> &glyphs,
+                 uint32_t atlas_width, uint32_t atlas_height, const std::vector<uint8_t> &atlas);
+
+    /**
+     * Adds a reachability table, ReachabilityTable::Bake passes its own rows and spawn ranges
+     */
+    void AddReachability(const FlightPhysics &physics, const std::vector<uint64_t> &reachable,
+                         const std::vector<int16_t> &next_ranges, uint32_t unused_transitions);
+
+    /**
+     * @return whether the whole pack was written
+     */
+    bool Write(const std::string &path) const;
+
+  private:
+    std::vector<BakedFont> fonts_;
+    std::vector<BakedGlyph> glyphs_;
+    std::vector<uint8_t> pixels_;
+    std::vector<BakedReachability> reachability_;
+    std::vector<uint64_t> reachable_bits_;
+    std::vector<int16_t> next_ranges_;
+};
+} // namespace flappybird
@@ -0,0 +1,148 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace flappybird {
+/**
+ * One hand designed pipe of an authored course, every field is a 32 bit word so records can be read straight out
+ * of the mapped file
+ */
+struct CoursePipe {
+    // distance from the left edge of the previous pipe to the left edge of this one, for the first pipe it is the
+    // distance from the right edge of the window
+    float spacing_ = 0;
+    // the gap runs from gap_bottom_ - gap_size_ to gap_bottom_, measured from the top of the window
+    float gap_bottom_ = 0;
+    float gap_size_ = 0;
+    float width_ = 0;
+    // how fast this pipe scrolls, in pixels per tick, pipes can be faster or slower than the ones around them
+    float speed_ = 0;
+    // 0xRRGGBB
+    uint32_t color_ = 0;
+};
+
+/**
+ * Course files start with this header followed by pipe_count_ CoursePipe records
+ * Every word is in host byte order, courses are built on the machine that plays them
+ */
+struct CourseHeader {
+    char magic_[8];
+    uint32_t version_;
+    uint32_t record_size_;
+    uint64_t pipe_count_;
+};
+
+static const char kCourseMagic[8] = {'F', 'B', 'C', 'O', 'U', 'R', 'S', 'E'};
+static const uint32_t kCourseVersion = 1;
+
+// limits every pipe is checked against, the playfield is the window minus the ground
+static const float kCourseFieldHeight = 552;
+static const float kCourseMinGap = 40;
+static const float kCourseMinWidth = 10;
+static const float kCourseMaxWidth = 200;
+static const float kCourseMinSpacing = 40;
+static const float kCourseMaxSpeed = 20;
+
+/**
+ * Read only view of a course file
+ * The file is memory mapped and pipes are only paged in when they are read, pages the course has scrolled past are
+ * handed back to the kernel so a course of any length plays in constant resident memory
+ */
+class CourseFile {
+  public:
+    CourseFile() = default;
+    ~CourseFile();
+    CourseFile(const CourseFile &) = delete;
+    CourseFile &operator=(const CourseFile &) = delete;
+    // moving hands the mapping over, so engines holding a course can still be moved
+    CourseFile(CourseFile &&other) noexcept;
+    CourseFile &operator=(CourseFile &&other) noexcept;
+
+    /**
+     * Maps a course file and checks its header, the pipes themselves are not touched
+     * @param path
+     * @param error set to the reason when the file can't be opened
+     * @return whether the course is ready to read
+     */
+    bool Open(const std::string &path, std::string &error);
+
+    /**
+     * Unmaps the file, safe to call when nothing is open
+     */
+    void Close();
+
+    bool IsOpen() const;
+    size_t GetPipeCount() const;
+
+    /**
+     * Reads one pipe, the page holding it is faulted in on first use
+     * @param index must be below GetPipeCount()
+     */
+    const CoursePipe &GetPipe(size_t index) const;
+
+    /**
+     * Tells the kernel the pipes before index won't be read again, pages are released in large steps so calling
+     * this every spawn is cheap
+     * @param index
+     */
+    void ReleaseBefore(size_t index);
+
+    /**
+     * Hands every page read so far back to the kernel, for reading the course again from its first pipe
+     */
+    void Rewind();
+
+  private:
+    void *mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+    const CoursePipe *pipes_ = nullptr;
+    size_t pipe_count_ = 0;
+    // byte offset into the mapping everything before which has been released
+    size_t released_bytes_ = 0;
+    static const size_t kReleaseStep = 1 << 20;
+};
+
+/**
+ * Checks a pipe against the course limits
+ * @param pipe
+ * @param error set to the first broken rule
+ * @return whether the pipe is playable
+ */
+bool ValidateCoursePipe(const CoursePipe &pipe, std::string &error);
+
+/**
+ * Parses one line of the text course format: spacing gap_bottom gap_size width speed color, with the color written
+ * as six hex digits, blank lines and lines starting with # are skipped
+ * @param line
+ * @param pipe
+ * @return whether the line held a pipe
+ */
+bool ParseCoursePipe(const std::string &line, CoursePipe &pipe);
+
+/**
+ * Streams pipes into a new course file, the pipe count in the header is filled in by Finish
+ */
+class CourseWriter {
+  public:
+    CourseWriter() = default;
+    ~CourseWriter();
+    CourseWriter(const CourseWriter &) = delete;
+    CourseWriter &operator=(const CourseWriter &) = delete;
+
+    bool Open(const std::string &path);
+    bool Write(const CoursePipe &pipe);
+
+    /**
+     * Writes the final header and closes the file
+     * @return whether everything reached the disk
+     */
+    bool Finish();
+
+  private:
+    std::FILE *file_ = nullptr;
+    uint64_t pipe_count_ = 0;
+};
+} // namespace flappybird
@@ -1,17 +1,106 @@
 #pragma once
 
+#include <atomic>
+#include <thread>
 #include "cinder/app/App.h"
 #include "cinder/gl/gl.h"
+#include "asset_pack.h"
 #include "game_engine.h"
+#include "score_verifier.h"
+#include "session_stats.h"
+#include "spectator_server.h"
+#include "spsc_queue.h"
+#include "triple_buffer.h"
 
 namespace flappybird {
 class FlappyBirdApp : public ci::app::App {
   private:
+    static const size_t kInputQueueSize = 64;
+
+    // baked fonts the engine draws from, declared first so it outlives the engine
+    AssetPack asset_pack_;
+    // the pack the asset baker writes next to the app, another one can be picked with --assets <path>
+    const string kAssetsArgument = "--assets";
+    const string kDefaultAssetPack = "flappy_bird.pack";
+
+    // owned by the simulation thread once setup() has started it
     GameEngine game_engine_ = GameEngine();
+    TripleBuffer<GameEngine::Snapshot> snapshots_;
+    SpscQueue<GameEngine::InputEvent, kInputQueueSize> input_queue_;
+    std::thread simulation_thread_;
+    // builds the reachability tables of the random modes the asset pack has none for while the start screen is up,
+    // the first spawn would otherwise stall the simulation thread for the time it takes
+    std::thread reachability_thread_;
+    std::atomic<bool> running_{false};
+    uint32_t tick_ = 0;
+
+    // only started when the app is launched with --spectate <port>
+    SpectatorServer spectator_server_;
+    SpectatorState spectator_state_;
+    const string kSpectateArgument = "--spectate";
+
+    // live counters for external monitoring, published to shared memory every tick
+    StatsPublisher stats_publisher_;
+    SessionStatsTracker stats_tracker_;
+    SessionStats session_stats_;
+
+    // an authored course file loaded with --course <path>
+    const string kCourseArgument = "--course";
+
+    // every finished run is written in the score verifier's text form, appended to the file given with
+    // --submissions <path> or printed on the console without one
+    string submissions_path_;
+    const string kSubmissionsArgument = "--submissions";
+
+    /**
+     * Writes out the run that just ended, runs the verifier can't replay are skipped
+     */
+    void SubmitRun();
+
+    // multi-bird runs, --players <n> local players on their own keys and --bots <n> gap following bots to race
+    const string kPlayersArgument = "--players";
+    const string kBotsArgument = "--bots";
+    const size_t kMaxBots = 10000;
+    const std::vector<int> kPlayerKeys = {ci::app::KeyEvent::KEY_SPACE, ci::app::KeyEvent::KEY_UP, 
+                                          ci::app::KeyEvent::KEY_w, ci::app::KeyEvent::KEY_RETURN};
+    const std::vector<const char *> kPlayerColors = {"yellow", "red", "blue", "purple"};
+    const char *kBotColor = "white";
+    const float kMinBotMargin = 5;
+    const float kMaxBotMargin = 45;
+
+    /**
+     * Fills the flock with the players and bots asked for on the command line
+     * @param num_players 
+     * @param num_bots 
+     */
+    void AddFlock(size_t num_players, size_t num_bots);
+
+    // how long after launch setup finished and the first frame was drawn, reported once on the console
+    bool first_frame_drawn_ = false;
+    const double kFirstFrameTargetMs = 50;
+
+    /**
+     * Simulation thread loop, applies forwarded input, advances the game at a fixed tick and publishes a snapshot
+     * after every tick
+     */
+    void RunSimulation();
+
+    /**
+     * Stops the simulation thread and waits for it to finish
+     */
+    void StopSimulation();
 
   public:
     FlappyBirdApp();
+    ~FlappyBirdApp() override;
     const int kWindowSize = 600;
+    const ci::Color kBackgroundColor = ci::Color("dodgerblue");
+    // if the simulation falls this many ticks behind it stops trying to catch up
+    const int kMaxTicksBehind = 5;
+
+    void setup() override;
+
+    void cleanup() override;
     
     void draw() override;
 
@@ -23,4 +112,3 @@ class FlappyBirdApp : public ci::app::App {
 };
 } // namespace flappybird
 
-
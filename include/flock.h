@@ -0,0 +1,163 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace flappybird {
+/**
+ * What a controller gets to see of its bird and the next gap ahead of it each tick
+ * When no gap is on screen the gap is the whole sky between the top of the window and the ground
+ */
+struct BirdObservation {
+    float y_ = 0;
+    float velocity_ = 0;
+    bool has_gap_ = false;
+    float gap_top_ = 0;
+    float gap_bottom_ = 0;
+    // from the bird to the left edge of the gap, negative while the bird is inside it
+    float gap_distance_ = 0;
+};
+
+/**
+ * Drives a bird that isn't flown from the keyboard, asked once per tick for every living bird it drives
+ */
+class BirdController {
+  public:
+    virtual ~BirdController() = default;
+
+    /**
+     * @param observation
+     * @return whether the bird should flap this tick
+     */
+    virtual bool ShouldFlap(const BirdObservation &observation) = 0;
+};
+
+/**
+ * Bot that keeps its bird a fixed distance above the bottom of the next gap, and in the middle of the sky when
+ * there is no gap to aim for
+ */
+class GapFollower : public BirdController {
+  public:
+    explicit GapFollower(float margin);
+    bool ShouldFlap(const BirdObservation &observation) override;
+
+  private:
+    float margin_;
+};
+
+/**
+ * A closed interval of heights that crashes a bird when the probe point y + offset_ falls inside it, the engine
+ * turns the pipes around the birds into spans once per tick and every bird is tested against the same spans
+ */
+struct FlockSpan {
+    float offset_;
+    float low_;
+    float high_;
+};
+
+/**
+ * Many birds flying the same obstacles, stored as a structure of arrays
+ * Every bird sits at the same x, so whatever depends on x (the gap ahead, which pipes can be hit, when a pipe is
+ * passed) is worked out once per tick by the engine and each step here is a flat loop over the birds
+ */
+class Flock {
+  public:
+    // key code of birds that are only flown by their controller
+    static const int kNoKey = -1;
+
+    /**
+     * Adds an unstarted bird
+     * @param key_code the key that flaps the bird, or kNoKey
+     * @param controller decides when the bird flaps, may be nullptr for birds flown from the keyboard
+     * @param color packed 0xAARRGGBB, only used for drawing
+     * @param y the start height
+     * @return the index of the bird
+     */
+    size_t AddBird(int key_code, std::shared_ptr<BirdController> controller, uint32_t color, float y);
+
+    /**
+     * Removes every bird
+     */
+    void Clear();
+
+    /**
+     * Puts every bird back at the start height, unstarted, alive and without points
+     * @param y
+     */
+    void Reset(float y);
+
+    /**
+     * Flaps a bird if it is alive and not already rising fast, the first flap starts the bird
+     * @param index
+     * @param flap_velocity
+     * @return whether the bird flapped
+     */
+    bool Flap(size_t index, float flap_velocity);
+
+    /**
+     * Asks the controller of every living bird whether to flap
+     * @param observation the gap ahead, the bird fields are filled in per bird
+     * @param flap_velocity
+     */
+    void RunControllers(BirdObservation observation, float flap_velocity);
+
+    /**
+     * Moves every started bird that hasn't landed, crashed birds fall with the death acceleration
+     * @param gravity
+     * @param death_acceleration
+     */
+    void Integrate(float gravity, float death_acceleration);
+
+    /**
+     * Crashes every living bird that touches one of the spans, the newly crashed birds are listed in
+     * GetCrashedThisTick() until the next call
+     * @param spans
+     * @param num_spans
+     */
+    void Collide(const FlockSpan *spans, size_t num_spans);
+
+    /**
+     * Stops every bird that reached the ground
+     * @param ground_y the height a bird's center lands at
+     */
+    void Land(float ground_y);
+
+    /**
+     * Gives a point to every living bird, called for each pipe the flock passes
+     */
+    void AwardPoint();
+
+    size_t GetCount() const;
+    size_t GetAliveCount() const;
+    // alive and started, the obstacles only scroll while at least one bird is flying
+    size_t GetFlyingCount() const;
+    size_t GetLandedCount() const;
+    uint32_t GetBestScore() const;
+    const float *GetY() const;
+    const float *GetVelocity() const;
+    const uint32_t *GetScores() const;
+    const uint32_t *GetColors() const;
+    int GetKeyCode(size_t index) const;
+    bool IsAlive(size_t index) const;
+    const std::vector<size_t> &GetCrashedThisTick() const;
+
+  private:
+    std::vector<float> y_;
+    std::vector<float> velocity_;
+    // flags are bytes rather than bools so the loops over them stay flat
+    std::vector<uint8_t> started_;
+    std::vector<uint8_t> crashed_;
+    std::vector<uint8_t> landed_;
+    std::vector<uint32_t> scores_;
+    std::vector<uint32_t> colors_;
+    std::vector<int> key_codes_;
+    std::vector<std::shared_ptr<BirdController>> controllers_;
+    // scratch space for Collide, kept between ticks so nothing allocates once the flock is built
+    std::vector<uint8_t> hits_;
+    std::vector<size_t> crashed_this_tick_;
+    size_t num_alive_ = 0;
+    size_t num_flying_ = 0;
+    size_t num_landed_ = 0;
+};
+} // namespace flappybird
@@ -2,8 +2,17 @@
 #include <iostream>
 #include <string>
 #include <list>
+#include <random>
 #include "cinder/gl/gl.h"
 #include "cinder/app/App.h"
+#include "cinder/gl/VertBatch.h"
+#include "course_file.h"
+#include "flock.h"
+#include "game_font.h"
+#include "particle_system.h"
+#include "reachability.h"
+#include "session_stats.h"
+#include "spectator_state.h"
 
 using std::string;
 using std::vector;
@@ -12,6 +21,8 @@ using glm::vec2;
 using ci::app::KeyEvent;
 using ci::app::MouseEvent;
 using ci::Rectf;
+using ci::Color;
+using ci::Font;
 
 namespace flappybird{
 class GameEngine {
@@ -42,6 +53,18 @@ class GameEngine {
      */
     void mouseDown(const MouseEvent &event);
 
+    /**
+     * Key press handling shared by keyDown and forwarded input events
+     * @param key_code the cinder key code of the pressed key
+     */
+    void HandleKeyPress(int key_code);
+
+    /**
+     * Mouse click handling shared by mouseDown and forwarded input events
+     * @param position the window position of the click
+     */
+    void HandleClick(const vec2 &position);
+
     //only the y velocity is considered for the bird so I didn't need to use a vec2 for velocity
     //the bird stays in the same x position while the obstacles move closer
     struct Bird {
@@ -50,9 +73,9 @@ class GameEngine {
         float y_velocity_ = 0.0;
         float acceleration_ = 0.0;
         float radius_;
-        char* color_;
-        const char* kOutlineColor = "black";
-        const float kOutlineWidth = 1.5;
+        Color color_;
+        Color kOutlineColor = Color("black");
+        float kOutlineWidth = 1.5;
         float gravity_ = 0.2;
         bool started_ = false;
         bool has_collided_ = false;
@@ -68,44 +91,71 @@ class GameEngine {
         Rectf lower_main_;
         Rectf upper_secondary_;
         Rectf lower_secondary_;
-        char* color_;
+        Color color_;
         float pipe_width_ = 10;
-        Obstacle(Rectf set_upper_main, Rectf set_lower_main, Rectf set_upper_secondary, Rectf set_lower_secondary, const char * set_color);
+        // how far the pipe moves left every tick
+        float speed_ = 0;
+        Obstacle() = default;
+        Obstacle(Rectf set_upper_main, Rectf set_lower_main, Rectf set_upper_secondary, Rectf set_lower_secondary, 
+                 const Color &set_color);
         void Display() const;
     };
 
+    // Pipe storm obstacles are plain intervals instead of rectangles, each one moves at its own speed and its gap
+    // oscillates around the storm's shared band, never far enough to leave the band uncovered
+    struct StormObstacle {
+        float x_ = 0;
+        float width_ = 0;
+        float speed_ = 0;
+        float gap_center_ = 0;
+        float gap_size_ = 0;
+        float amplitude_ = 0;
+        float phase_ = 0;
+        float frequency_ = 0;
+        float GetRight() const;
+        float GetGapTop() const;
+        float GetGapBottom() const;
+    };
+
     struct Ground {
         Rectf top_;
         Rectf bottom_;
-        char* top_color_;
-        char* bottom_color_;
+        Color top_color_;
+        Color bottom_color_;
         Ground(Rectf set_top, Rectf set_bottom, const char * set_top_color, const char * set_bottom_color);
         void Display() const;
     };
 
     struct Button {
         Rectf area_;
-        char* color_;
+        Color color_;
         string title_;
         bool highlighted_ = false;
         const string kGameFont = "Times New Roman";
-        const char* kGameTextColor = "white";
-        const char* kHighlightColor = "darkgray";
+        const Color kGameTextColor = Color("white");
+        const Color kHighlightColor = Color("darkgray");
         const float kPositionAverage = 2;
         const float kTitlePositionDivider = 3;
         const float kHighlightWidthDivider = 10;
         float font_size_;
+        GameFont font_;
         Button(Rectf set_area, const char * set_color, string set_title, float set_font_size);
-        void Display() const;
+        void LoadFont(const AssetPack *pack);
+        void Display(bool highlighted) const;
     };
 
     struct Leaderboard {
         Leaderboard();
-        void Display();
+        void LoadFonts(const AssetPack *pack);
+        void Display(const size_t* scores) const;
         vector<size_t> scores_ = {0, 0, 0, 0, 0};
-        void ManageScores();
+        /**
+         * Inserts a new score into the sorted top scores in place, dropping the lowest one
+         * @param new_score 
+         */
+        void ManageScores(size_t new_score);
         const string kGameFont = "Times New Roman";
-        const char* kGameTextColor = "white";
+        const Color kGameTextColor = Color("white");
         const float kLineGap = 60;
         const string kLeaderboardTitle = "Leaderboard";
         const string kDot = ".";
@@ -116,6 +166,13 @@ class GameEngine {
         const float kFirstLineX1_Position = 100;
         const float kFirstLineX2_Position = 500;
         const float kFirstLineY1_Position = 150;
+        const float kScoreFontSize = 20;
+        GameFont title_font_;
+        GameFont score_font_;
+        // labels are built once and only rewritten when a score changes so drawing never allocates
+        vector<string> rank_labels_;
+        mutable vector<string> score_labels_;
+        mutable vector<size_t> displayed_scores_;
     };
 
     // GameState enum that helps decide what to display
@@ -127,14 +184,191 @@ class GameEngine {
         CustomizeScreen
     };
 
+    // GameMode enum that decides the obstacle layout and physics of a run
+    enum GameMode {
+        Normal,
+        Challenge,
+        PipeStorm,
+        Course
+    };
+
+    // Input forwarded from the window thread to the simulation thread
+    struct InputEvent {
+        enum Type {
+            KeyPress,
+            Click
+        };
+        Type type_ = KeyPress;
+        int key_code_ = 0;
+        vec2 position_;
+    };
+
+    /**
+     * Applies a forwarded key press or click
+     * @param input 
+     */
+    void HandleInput(const InputEvent &input);
+
+    static const size_t kSnapshotLeaderboardSize = 5;
+    static const size_t kMaxParticles = 4096;
+
+    // Immutable copy of everything the screens need to draw one frame, so the render thread never touches the
+    // live simulation state
+    struct Snapshot {
+        GameState game_state_ = StartScreen;
+        Bird bird_ = Bird(0, 0, "yellow", 0);
+        // holds every obstacle collisions are tested against that overlaps the window, hundreds in the storm, only
+        // grown and never shrunk so a slot stops allocating once it has seen the busiest frame of a mode
+        vector<Obstacle> obstacles_;
+        size_t num_obstacles_ = 0;
+        size_t score_ = 0;
+        size_t leaderboard_scores_[kSnapshotLeaderboardSize] = {};
+        float particle_x_[kMaxParticles];
+        float particle_y_[kMaxParticles];
+        float particle_life_[kMaxParticles];
+        ParticleSystem::Kind particle_kinds_[kMaxParticles];
+        size_t num_particles_ = 0;
+        // flock birds all sit at the bird's x, colors are packed 0xAARRGGBB, sized to the flock so a snapshot
+        // without one stays small, slots are reused so they only allocate when the flock grows
+        vector<float> flock_y_;
+        vector<uint32_t> flock_colors_;
+        bool normal_highlighted_ = false;
+        bool challenge_highlighted_ = false;
+        bool storm_highlighted_ = false;
+        bool course_loaded_ = false;
+        bool course_highlighted_ = false;
+        bool red_highlighted_ = false;
+        bool yellow_highlighted_ = false;
+        bool blue_highlighted_ = false;
+        bool purple_highlighted_ = false;
+        bool orange_highlighted_ = false;
+        bool green_highlighted_ = false;
+    };
+
+    /**
+     * Gets every font the screens draw with ready, must be called on the drawing thread before Display
+     * @param pack baked glyph atlases to draw from instead of loading fonts, may be nullptr, must outlive the engine
+     */
+    void LoadFonts(const AssetPack *pack = nullptr);
+
+    /**
+     * The font every screen draws with and every size it is drawn at, the asset baker bakes exactly these
+     */
+    const string &GetFontName() const;
+    vector<float> GetFontSizes() const;
+
+    /**
+     * Copies the current game state into a snapshot without allocating
+     * @param snapshot 
+     */
+    void WriteSnapshot(Snapshot &snapshot) const;
+
+    /**
+     * Draws a snapshot, only reads state that never changes after construction so it is safe to call from the
+     * render thread while the simulation thread keeps advancing
+     * @param snapshot 
+     */
+    void Display(const Snapshot &snapshot) const;
+
+    /**
+     * Copies the part of the current tick that is streamed to spectators
+     * @param state 
+     */
+    void WriteSpectatorState(SpectatorState &state) const;
+
+    /**
+     * Copies the game side of the live stats, the rates and timings are filled in by whoever drives the ticks
+     * @param stats 
+     */
+    void WriteSessionStats(SessionStats &stats) const;
+
+    /**
+     * The rate the simulation should be ticked at for the selected mode
+     */
+    double GetTicksPerSecond() const;
+
+    /**
+     * Seeds the engine's own random number generator, every obstacle layout comes from it so a seed and the
+     * input log of a run are enough to replay the run exactly
+     * @param seed 
+     */
+    void SetSeed(unsigned seed);
+
+    /**
+     * Resets the engine and drops it straight into a fresh run, used to replay runs without going through the
+     * start screen
+     * @param seed 
+     * @param game_mode 
+     */
+    void StartRun(unsigned seed, GameMode game_mode);
+
+    /**
+     * The seed and flap log of the current run, or of the last one once it is over, together with the mode they are
+     * enough to replay the run
+     * Every run started from the start screen gets a fresh seed, flap frames count the ticks since the run started
+     */
+    unsigned GetRunSeed() const;
+    const vector<size_t> &GetRunFlapFrames() const;
+    GameMode GetGameMode() const;
+
+    /**
+     * Whether the current run ended in a death, that is the bird, or every flock bird, came down
+     * Finishing a course, or running into a broken course pipe, also ends on the game over screen but is no death
+     */
+    bool HasDied() const;
+
+    /**
+     * Maps an authored course file and switches to course mode, pipes are read from the file as they scroll in
+     * Only the header is checked, so even a huge course loads at once, a broken pipe ends the run when it comes up,
+     * course-tool validate checks every pipe of a file ahead of time
+     * @param path 
+     * @param error set to the reason the course couldn't be loaded
+     * @return whether the course was loaded
+     */
+    bool LoadCourse(const string &path, string &error);
+
+    /**
+     * Why the current course run was ended early, empty unless one of its pipes turned out to be broken
+     */
+    const string &GetCourseError() const;
+
+    /**
+     * Adds a bird to the flock, once the flock has birds every run is flown by the flock instead of the single bird
+     * All the birds share the obstacles, which keep scrolling while any of them is flying, and the run is over once
+     * every bird is on the ground
+     * @param key_code the key that flaps the bird, Flock::kNoKey for birds only flown by their controller
+     * @param controller decides when the bird flaps, may be nullptr for birds flown from the keyboard
+     * @param bird_color 
+     * @return the index of the bird in the flock
+     */
+    size_t AddFlockBird(int key_code, std::shared_ptr<BirdController> controller, const Color &bird_color);
+
+    /**
+     * Removes every flock bird, runs go back to being flown by the single bird
+     */
+    void ClearFlock();
+
+    const Flock &GetFlock() const;
+
+    /**
+     * The physics and obstacle layout of a mode as the reachability tables see them, only meaningful for the normal
+     * and challenge modes whose gaps are spawned at random
+     * @param game_mode 
+     */
+    FlightPhysics GetFlightPhysics(GameMode game_mode) const;
+
     /**
      * Getters and Setters for Testing Purposes 
      */
     vector<Obstacle> GetObstacles();
     void SetGameState(GameState game_state);
+    GameState GetGameState() const;
     Bird GetBird();
     size_t GetScore() const;
     bool GetHasCollided() const;
+    size_t GetParticleCount() const;
+    void SetGameMode(GameMode game_mode);
+    vector<StormObstacle> GetStormObstacles();
 
   private:
     /**
@@ -158,6 +392,111 @@ class GameEngine {
      */
     void HandleCollision();
 
+    /**
+     * Fills the storm with obstacles the first time it is needed, then moves every storm obstacle, recycles the ones
+     * that left the window to the back of the storm and keeps the obstacles sorted by x
+     * Scoring happens here too since a storm pipe is passed the moment its right edge crosses the bird
+     */
+    void UpdateStormObstacles();
+
+    /**
+     * Gives a storm obstacle new random width, speed and gap
+     * @param obstacle 
+     */
+    void RandomizeStormObstacle(StormObstacle &obstacle);
+
+    /**
+     * Returns a random float in [low, high] from the engine's generator
+     */
+    float RandomBetween(float low, float high);
+
+    /**
+     * Seeds the engine's generator for a new run and starts its flap log
+     * @param seed 
+     */
+    void BeginRun(unsigned seed);
+
+    /**
+     * Sweep and prune broadphase, returns the range of sorted storm obstacles whose x interval overlaps
+     * [left, right], so only nearby pipes ever reach the narrow phase
+     * @param left 
+     * @param right 
+     * @param first set to the index of the first overlapping obstacle
+     * @param last set to one past the index of the last overlapping obstacle
+     */
+    void FindStormObstacles(float left, float right, size_t &first, size_t &last) const;
+
+    /**
+     * Storm version of HandleCollision, tests the bird against the pipes the broadphase returns
+     */
+    void HandleStormCollision();
+
+    /**
+     * Course version of UpdateObstacleVector and UpdateScore, spawns the next authored pipes once they reach the
+     * window, removes the ones that left it, scores the ones the bird passed and ends the run after the last pipe
+     * Pipes can have any speed and spacing so everything here compares against thresholds instead of exact positions
+     */
+    void UpdateCourseObstacles();
+
+    /**
+     * Rewinds the loaded course to its first pipe
+     */
+    void RestartCourse();
+
+    /**
+     * Whether runs are flown by the flock rather than the single bird
+     */
+    bool IsFlockRun() const;
+
+    /**
+     * Whether the obstacles move this tick, they wait for the first flap and stop once nobody is flying
+     */
+    bool IsScrolling() const;
+
+    /**
+     * Scores the pipe that was just passed, for the single bird or for every living flock bird
+     */
+    void AwardPoint();
+
+    /**
+     * Moves the birds and checks them against the obstacles of the current mode
+     */
+    void AdvanceBirds();
+
+    /**
+     * Flock version of moving the birds, HandleCollision and HandleDeath
+     * The pipes that can touch the birds are turned into spans once, then every bird is tested against them
+     */
+    void AdvanceFlock();
+
+    /**
+     * Collects the heights at which a bird at the shared x touches the ground, the ceiling or a pipe
+     */
+    void FindFlockSpans();
+
+    /**
+     * Describes the next gap ahead of the shared bird x for controllers
+     * @param observation 
+     */
+    void FindNextGap(BirdObservation &observation) const;
+
+    /**
+     * The reachability table of the selected mode, looked up on the first spawn after a mode change
+     */
+    const ReachabilityTable &GetReachability();
+
+    /**
+     * Draws every flock bird with one batched draw call
+     * @param snapshot 
+     */
+    void DisplayFlock(const Snapshot &snapshot) const;
+
+    /**
+     * Switches between the normal, challenge, pipe storm and course modes
+     * @param game_mode 
+     */
+    void SelectMode(GameMode game_mode);
+
     /**
      * This method brings about the Game Over screen once the falling bird touches the ground
      */
@@ -172,11 +511,24 @@ class GameEngine {
      * Screen Display methods that draw what is necessary for the respective screen when the current games screen 
      * is that screen
      */
-    void DisplayStartScreen();
-    void DisplayCustomizeScreen();
-    void DisplayLeaderboard();
-    void DisplayGameScreen();
-    void DisplayGameOverScreen();
+    void DisplayStartScreen(const Snapshot &snapshot) const;
+    void DisplayCustomizeScreen(const Snapshot &snapshot) const;
+    void DisplayLeaderboard(const Snapshot &snapshot) const;
+    void DisplayGameScreen(const Snapshot &snapshot) const;
+    void DisplayGameOverScreen(const Snapshot &snapshot) const;
+
+    /**
+     * Draws every particle in the snapshot with one batched draw call
+     * @param snapshot 
+     */
+    void DisplayParticles(const Snapshot &snapshot) const;
+
+    /**
+     * Rewrites the cached score strings when the displayed score changes, the strings have reserved capacity so
+     * this never allocates
+     * @param score 
+     */
+    void UpdateScoreText(size_t score) const;
 
     // size of the game window
     const float kWindowSize = 600;
@@ -184,6 +536,16 @@ class GameEngine {
     // score variable that keeps track of score
     size_t score_ = 0;
 
+    // every random choice the simulation makes comes from here, effects use their own generator
+    std::mt19937 random_engine_;
+    // draws the seed of every run started from the start screen
+    std::mt19937 seed_engine_ = std::mt19937(std::random_device()());
+    unsigned run_seed_ = 0;
+    size_t run_frame_ = 0;
+    vector<size_t> run_flap_frames_;
+    // a few flaps a second for longer than a typical run, longer runs still log every flap
+    const size_t kReservedRunFlaps = 4096;
+
     // Bird class fields and constants
     bool has_collided_ = false;  
     const float kX_Position = 150.0;
@@ -192,6 +554,7 @@ class GameEngine {
     const float kRadius = 10.0;
     Bird bird_ = Bird(kX_Position, kInitialY_Position, kBirdColor, kRadius);
     const float kBirdDeathAcceleration = 0.25;
+    float bird_death_acceleration_ = kBirdDeathAcceleration;
 
     // Ground class fields and constants
     const float kTopHeight = 8;
@@ -207,16 +570,70 @@ class GameEngine {
 
     // Obstacle class fields and constants
     vector<Obstacle> obstacles_;
-    const char* kObstacleColor = "green";
+    Color kObstacleColor = Color("green");
     const float kNumObstaclesOnScreen = 2;
     const float kStartingIncrement = 700;
     const float kGapSize = 95;
     const float kObstacleWidth = 50;
     const float kLowerBoundDivider = 4; 
+    // the speed newly spawned pipes get, pipes keep the speed they were spawned with
     float ObstacleSpeed = 2;
     const float kSecondaryPipeWidth = 10;
     const float kSecondaryPipeHeight = 50;
     const size_t kObstacleRange = 401 - kGroundHeight;
+    // every gap after the first is drawn from the gaps this says the bird can reach from the one before it
+    const ReachabilityTable *reachability_ = nullptr;
+
+    // Pipe storm fields and constants, the storm ticks four times as often as the other modes so its speeds are per
+    // storm tick and the bird physics are scaled down to match
+    GameMode game_mode_ = Normal;
+    vector<StormObstacle> storm_obstacles_;
+    const size_t kStormObstacleCount = 1000;
+    const float kStormCourseLength = 2400;
+    const float kStormStartingX = kWindowSize / 2;
+    const float kStormMinWidth = 10;
+    const float kStormMaxWidth = 40;
+    const float kStormMinSpeed = 0.3;
+    const float kStormMaxSpeed = 1;
+    const float kStormMinGap = 140;
+    const float kStormMaxGap = 190;
+    const float kStormMinFrequency = 0.005;
+    const float kStormMaxFrequency = 0.02;
+    // every storm gap holds the band, a corridor of kStormBandHeight that drifts slowly up and down the window, so
+    // however many pipes overlap the bird there is always a way through all of them
+    float storm_band_phase_ = 0;
+    float storm_band_center_ = 0;
+    const float kStormBandHeight = 120;
+    const float kStormBandCenter = (kWindowSize - kGroundHeight) / 2;
+    const float kStormBandAmplitude = 90;
+    const float kStormBandFrequency = 0.0015;
+    // controllers see the gap every pipe this far ahead of the bird leaves open, not only the nearest pipe's
+    const float kStormLookAhead = 100;
+    const float kStormLipWidth = 2;
+    const float kStormLipHeight = 10;
+    const double kStormTicksPerSecond = 240;
+    const double kDefaultTicksPerSecond = 60;
+    const float kStormTickScale = 0.25;
+    const float kTwoPi = 6.28318531;
+
+    // Authored course fields, last_course_x_ is where the left edge of the last spawned pipe currently is, the right
+    // edge of the window before the first one
+    CourseFile course_;
+    size_t next_course_pipe_ = 0;
+    bool course_finished_ = false;
+    string course_error_;
+    float last_course_x_ = 0;
+    // the most course pipes that fit between the left edge and the spawn point at the minimum spacing
+    const size_t kMaxCourseObstacles = 32;
+
+    // Multi-bird runs, controller driven birds are drawn see-through so the players stand out among them
+    Flock flock_;
+    vector<FlockSpan> flock_spans_;
+    const float kGhostAlpha = 0.35;
+    const size_t kFlockBirdSegments = 8;
+    mutable ci::gl::VertBatchRef flock_batch_;
+    // the rim of a flock bird around its center, kFlockBirdSegments + 1 points so segment i runs from i to i + 1
+    mutable vector<vec2> flock_bird_rim_;
     
     // The current game screen
     GameState current_game_state_ = StartScreen;
@@ -226,6 +643,8 @@ class GameEngine {
     Button start_customize_ = Button(Rectf(vec2(450, 465), vec2(550, 490)), "purple", "Customize", 15);
     Button start_challenge_ = Button(Rectf(vec2(450, 430), vec2(550, 455)), "black", "Challenge", 15);
     Button start_normal_ = Button(Rectf(vec2(450, 395), vec2(550, 420)), "yellowgreen", "Normal", 15);
+    Button start_storm_ = Button(Rectf(vec2(450, 360), vec2(550, 385)), "darkred", "Pipe Storm", 15);
+    Button start_course_ = Button(Rectf(vec2(450, 325), vec2(550, 350)), "darkorange", "Course", 15);
     Button gameover_restart_ = Button(Rectf(vec2(100, 400), vec2(275 , 500)), "orange", "Restart", 30);
     Button gameover_leaderboard_ = Button(Rectf(vec2(325, 400), vec2(500 , 500)), "red", "Leaderboard", 30);
     Button back_ = Button(Rectf(vec2(50, 50), vec2(150, 75)), "red", "Back", 15);
@@ -237,10 +656,13 @@ class GameEngine {
     Button customize_green_ = Button(Rectf(vec2(400, 350), vec2(500, 450)), "green", "", 30);
     
     Leaderboard leaderboard_ = Leaderboard();
+
+    // snapshot used by the single threaded Display()
+    Snapshot display_snapshot_;
     
     // Game String Constants
     const string kGameFont = "Times New Roman";
-    const char* kGameTextColor = "white";
+    const Color kGameTextColor = Color("white");
     const string kGameTitle = "Flappy Bird";
     const float kTitleX_Position = kWindowSize / 2;
     const float kTitleY_Position = kWindowSize / 12;
@@ -271,13 +693,48 @@ class GameEngine {
     const float kFinalScoreMessage_X_Position = kWindowSize / 2;
     const float kFinalScoreMessage_Y_Position = kWindowSize / 2;
     const float kFinalScoreMessageFontSize = kWindowSize / 15;
+
+    // Particle effects for flaps, points and crashes, lifetimes and speeds are in normal mode ticks
+    ParticleSystem particles_ = ParticleSystem(kMaxParticles);
+    const float kParticleGravity = 0.1;
+    const size_t kFeatherCount = 12;
+    const float kFeatherSpeed = 1.5;
+    const float kFeatherLifetime = 30;
+    const float kFeatherSize = 2;
+    const size_t kSparkCount = 24;
+    const float kSparkSpeed = 3;
+    const float kSparkLifetime = 20;
+    const float kSparkSize = 1.5;
+    const size_t kDebrisCount = 150;
+    const float kDebrisSpeed = 5;
+    const float kDebrisLifetime = 45;
+    const float kDebrisSize = 2.5;
+    const float kParticleFadeTicks = 10;
+    const Color kFeatherColor = Color("white");
+    const Color kSparkColor = Color("gold");
+    const Color kDebrisColor = Color("orangered");
+    mutable ci::gl::VertBatchRef particle_batch_;
+
+    // Fonts and score text used by the display methods, only touched by the drawing thread
+    bool fonts_loaded_ = false;
+    GameFont title_font_;
+    GameFont instruction_font_;
+    GameFont option_font_;
+    GameFont score_font_;
+    GameFont game_over_title_font_;
+    GameFont final_score_font_;
+    static const size_t kScoreTextCapacity = 32;
+    mutable size_t displayed_score_ = 0;
+    mutable string score_text_;
+    mutable string final_score_text_;
     
     // Game Constants
-    const char* kLeaderboardBackground = "gray";
-    const char* kGameOverBackground = "blue";
+    const Color kLeaderboardBackground = Color("gray");
+    const Color kGameOverBackground = Color("blue");
     const float kObstacleDelay = 20;
     const float kFlapVelocity = -5;
     const float kFlapBoundary = kFlapVelocity / 2;
+    float flap_velocity_ = kFlapVelocity;
     const float kNormalObstacleSpeed = 2;
     const float kNormalGravity = 0.2;
     const float kChallengeObstacleSpeed = 5;
@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include "cinder/gl/gl.h"
+#include "cinder/gl/VertBatch.h"
+#include "asset_pack.h"
+
+namespace flappybird {
+/**
+ * A font the screens draw text with
+ * When the asset pack has the font baked at this size the text is drawn as quads out of the baked glyph atlas, which
+ * is uploaded once straight from the pack, otherwise it falls back to cinder's font loading and string rendering
+ */
+class GameFont {
+  public:
+    /**
+     * Gets the font ready to draw, must be called on the drawing thread
+     * @param name 
+     * @param size 
+     * @param pack the baked assets, may be nullptr, must outlive the font
+     */
+    void Load(const std::string &name, float size, const AssetPack *pack);
+
+    /**
+     * Draws text horizontally centered on position, positioned the same way as drawStringCentered
+     * @param text 
+     * @param position 
+     * @param text_color 
+     */
+    void DrawCentered(const std::string &text, const glm::vec2 &position, const ci::ColorA &text_color) const;
+
+    bool IsBaked() const;
+
+  private:
+    const AssetPack *pack_ = nullptr;
+    const BakedFont *baked_ = nullptr;
+    ci::gl::Texture2dRef atlas_;
+    ci::gl::GlslProgRef shader_;
+    mutable ci::gl::VertBatchRef batch_;
+    ci::Font font_;
+};
+} // namespace flappybird
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace flappybird {
+/**
+ * Fixed capacity particle pool for visual effects, stored as a structure of arrays so the update kernel can run
+ * over four particles at a time with SIMD
+ * Dead particles are swap-removed so the live ones always sit in [0, GetCount())
+ * Effects draw from their own random number generator, so they never touch the game's mt19937 stream and replays
+ * stay the same with or without them
+ */
+class ParticleSystem {
+  public:
+    enum Kind : uint8_t {
+        Feather,
+        Spark,
+        Debris
+    };
+
+    /**
+     * Allocates every array once, nothing allocates after construction
+     * @param capacity the most particles that can be alive at once
+     */
+    explicit ParticleSystem(size_t capacity);
+
+    /**
+     * Emits a burst of particles flying out from a point in random directions
+     * Particles that don't fit in the pool are dropped
+     * @param kind 
+     * @param x 
+     * @param y 
+     * @param count number of particles in the burst
+     * @param speed the fastest a particle may fly, in pixels per tick
+     * @param lifetime how many ticks the particles live
+     */
+    void Emit(Kind kind, float x, float y, size_t count, float speed, float lifetime);
+
+    /**
+     * Moves every particle, applies gravity, ages them and removes the dead ones
+     * @param gravity downwards acceleration in pixels per tick squared
+     * @param time_step length of this update in ticks
+     */
+    void Update(float gravity, float time_step);
+
+    /**
+     * Removes every particle
+     */
+    void Clear();
+
+    size_t GetCount() const;
+    size_t GetCapacity() const;
+    const float *GetX() const;
+    const float *GetY() const;
+    const float *GetLife() const;
+    const Kind *GetKinds() const;
+
+  private:
+    /**
+     * SIMD kernel that integrates positions and velocities and ages every live particle
+     */
+    void Integrate(float gravity, float time_step);
+
+    /**
+     * Swap-removes every particle whose life ran out
+     */
+    void RemoveDead();
+
+    /**
+     * xorshift random float in [0, 1)
+     */
+    float NextRandom();
+
+    size_t capacity_;
+    size_t count_ = 0;
+    std::vector<float> x_;
+    std::vector<float> y_;
+    std::vector<float> velocity_x_;
+    std::vector<float> velocity_y_;
+    std::vector<float> life_;
+    std::vector<Kind> kinds_;
+    uint32_t random_state_ = 2463534242u;
+};
+} // namespace flappybird
@@ -0,0 +1,138 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace flappybird {
+class AssetPack;
+class AssetPackWriter;
+struct BakedReachability;
+
+/**
+ * Everything about a mode's physics and obstacle layout that decides whether the bird can fly from one gap to the
+ * next, distances are in pixels and times in ticks
+ */
+struct FlightPhysics {
+    float gravity_ = 0;
+    float flap_velocity_ = 0;
+    float obstacle_speed_ = 0;
+    float bird_radius_ = 0;
+    // how far an obstacle reaches along x, lips included
+    float obstacle_width_ = 0;
+    // the closest the left edges of two consecutive obstacles ever get
+    float obstacle_spacing_ = 0;
+    float gap_size_ = 0;
+    // the bird hits the ceiling at ceiling_ and lands at ground_
+    float ceiling_ = 0;
+    float ground_ = 0;
+    // every gap's lower edge is in [min_gap_bottom_, max_gap_bottom_]
+    int min_gap_bottom_ = 0;
+    int max_gap_bottom_ = 0;
+};
+
+bool operator<(const FlightPhysics &left, const FlightPhysics &right);
+
+/**
+ * Which gap to gap transitions a bird can fly, for every pair of gap heights of one mode
+ * A transition is reachable when some flap sequence takes a bird that enters the first gap anywhere inside it, rising
+ * or falling no faster than a flap, through that gap, across to the next one and through it
+ * Heights are searched one pixel apart along exact flap arcs, kSafetyMargin keeps the rounding of the search on the
+ * safe side
+ */
+class ReachabilityTable {
+  public:
+    /**
+     * Runs the search, takes a noticeable fraction of a second so the game goes through Get()
+     * @param physics
+     */
+    explicit ReachabilityTable(const FlightPhysics &physics);
+
+    /**
+     * The table for a set of physics, computed the first time it is asked for unless LoadBaked() already had it, and
+     * shared by every engine after that, safe to call from several threads, a table being built only holds up callers
+     * asking for the same physics
+     * @param physics
+     */
+    static const ReachabilityTable &Get(const FlightPhysics &physics);
+
+    /**
+     * Hands the tables baked into a pack to Get(), so physics the pack was baked for never need a search
+     * Tables are copied out of the pack, physics Get() already has a table for are skipped
+     * @param pack
+     * @return how many tables were added
+     */
+    static size_t LoadBaked(const AssetPack &pack);
+
+    /**
+     * Adds the table to a pack for LoadBaked() to pick up
+     * @param writer
+     */
+    void Bake(AssetPackWriter &writer) const;
+
+    /**
+     * @param from_gap_bottom
+     * @param to_gap_bottom
+     * @return whether a bird can fly from a gap with the first lower edge to one with the second
+     */
+    bool IsReachable(int from_gap_bottom, int to_gap_bottom) const;
+
+    /**
+     * The range of next gaps reachable from a gap, every lower edge in [GetMinNext(), GetMaxNext()] is reachable
+     * The range is empty, min above max, if nothing is, gaps outside the table are treated like the nearest gap
+     * inside it
+     */
+    int GetMinNext(int from_gap_bottom) const;
+    int GetMaxNext(int from_gap_bottom) const;
+
+    /**
+     * Both ends of the range at once, the spawner's one lookup per gap
+     * @param from_gap_bottom
+     * @param min_next
+     * @param max_next
+     */
+    void GetNextRange(int from_gap_bottom, int &min_next, int &max_next) const;
+
+    /**
+     * How many reachable transitions lie outside the [GetMinNext(), GetMaxNext()] ranges, 0 unless the reachable
+     * next gaps of some gap have holes in them
+     */
+    size_t GetUnusedTransitions() const;
+
+    const FlightPhysics &GetPhysics() const;
+
+    static const float kSafetyMargin;
+
+  private:
+    /**
+     * An empty table of the baked physics' size for LoadBaked() to copy the rows into
+     * @param baked
+     */
+    explicit ReachabilityTable(const BakedReachability &baked);
+
+    // sizes the rows and ranges for physics_, nothing reachable yet
+    void Allocate();
+    size_t Index(int gap_bottom) const;
+
+    FlightPhysics physics_;
+    size_t num_gaps_;
+    // row i holds the next gaps reachable from gap min_gap_bottom_ + i, one bit each
+    size_t words_per_row_;
+    std::vector<uint64_t> reachable_;
+    // min_next_ and max_next_ of a gap side by side so the spawner touches one cache line
+    std::vector<int16_t> next_ranges_;
+    size_t unused_transitions_ = 0;
+};
+
+/**
+ * Picks the lower edge of the next gap in [lowest, lowest + range), drawing one number from random and only choosing
+ * among the gaps the table says are reachable from the previous one
+ * @param table may be nullptr for the first gap of a run, which any lower edge is fine for
+ * @param previous_gap_bottom
+ * @param lowest
+ * @param range
+ * @param random
+ */
+float PickGapBottom(const ReachabilityTable *table, float previous_gap_bottom, float lowest, size_t range,
+                    std::mt19937 &random);
+} // namespace flappybird
@@ -0,0 +1,129 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "game_engine.h"
+
+namespace flappybird {
+/**
+ * A claimed score together with everything needed to replay the run that produced it
+ * Text form, one submission per line: <seed> <normal|challenge|storm> <claimed score> <flap frame>...
+ * Flap frames are the ticks, counted from the start of the run, on which space was pressed
+ */
+struct Submission {
+    string id_;
+    unsigned seed_ = 0;
+    GameEngine::GameMode mode_ = GameEngine::Normal;
+    size_t claimed_score_ = 0;
+    vector<size_t> flap_frames_;
+};
+
+/**
+ * The result of replaying a submission
+ * A rejected claim carries the first frame where the replay stopped agreeing with it: the frame the replayed score
+ * went past the claim, the frame the bird died short of it, or the frame the run was cut off
+ * Flap logs no real run can produce, not starting at frame 0 or leaving the bird longer without a flap than it can
+ * stay up, are rejected without a replay
+ */
+struct Verdict {
+    bool accepted_ = false;
+    size_t simulated_score_ = 0;
+    size_t divergence_frame_ = 0;
+};
+
+/**
+ * Parses one line of the text form
+ * @param line 
+ * @param submission 
+ * @return false for blank lines, comments starting with # and malformed lines
+ */
+bool ParseSubmission(const string &line, Submission &submission);
+
+/**
+ * Writes a submission in the text form ParseSubmission reads
+ * @param submission 
+ * @return 
+ */
+string FormatSubmission(const Submission &submission);
+
+/**
+ * Turns the run an engine just played into a submission claiming the score it reached
+ * @param game_engine 
+ * @param submission 
+ * @return false for runs the text form can't describe, course runs and flock runs
+ */
+bool MakeSubmission(const GameEngine &game_engine, Submission &submission);
+
+/**
+ * Replays a submission on an engine and checks its claim, the engine is reset first so one engine can verify any
+ * number of submissions
+ * @param submission 
+ * @param game_engine 
+ * @return 
+ */
+Verdict VerifySubmission(const Submission &submission, GameEngine &game_engine);
+
+/**
+ * Local stand-in for the submission queue, a blocking queue any number of threads can push to and pop from
+ */
+class SubmissionQueue {
+  public:
+    /**
+     * @param capacity Push blocks while this many submissions are waiting
+     */
+    explicit SubmissionQueue(size_t capacity);
+
+    void Push(Submission submission);
+
+    /**
+     * Waits for a submission
+     * @param submission 
+     * @return false once the queue is closed and empty
+     */
+    bool Pop(Submission &submission);
+
+    /**
+     * Signals that nothing else will be pushed
+     */
+    void Close();
+
+  private:
+    size_t capacity_;
+    bool closed_ = false;
+    std::deque<Submission> submissions_;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+};
+
+/**
+ * Verifies submissions from a queue on a pool of worker threads, each worker keeps one engine for its whole life
+ * so verifying a run never has to build a new engine
+ */
+class ScoreVerifier {
+  public:
+    typedef std::function<void(const Submission &, const Verdict &)> VerdictCallback;
+
+    /**
+     * @param num_workers number of worker threads, 0 uses one per core
+     */
+    explicit ScoreVerifier(size_t num_workers);
+
+    /**
+     * Verifies everything in the queue until it is closed and drained
+     * @param queue 
+     * @param on_verdict called from the worker threads for every verified submission
+     */
+    void Run(SubmissionQueue &queue, const VerdictCallback &on_verdict);
+
+    size_t GetWorkerCount() const;
+
+  private:
+    size_t num_workers_;
+    vector<GameEngine> engines_;
+};
+} // namespace flappybird
@@ -0,0 +1,186 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace flappybird {
+/**
+ * Live counters of one game session, published every tick for external monitoring
+ * Every field is exactly one 32 bit word so the block can be copied in and out of shared memory word by word
+ */
+struct SessionStats {
+    uint32_t pid_ = 0;
+    uint32_t tick_ = 0;
+    uint32_t game_state_ = 0;
+    uint32_t game_mode_ = 0;
+    uint32_t score_ = 0;
+    uint32_t obstacle_count_ = 0;
+    uint32_t deaths_ = 0;
+    float deaths_per_minute_ = 0;
+    float ticks_per_second_ = 0;
+    // how long the simulation spent on a tick, over the last kFrameTimeSamples ticks
+    float frame_time_p50_us_ = 0;
+    float frame_time_p90_us_ = 0;
+    float frame_time_p99_us_ = 0;
+    float frame_time_max_us_ = 0;
+};
+
+static const size_t kSessionStatsWords = sizeof(SessionStats) / sizeof(uint32_t);
+static_assert(sizeof(SessionStats) == kSessionStatsWords * sizeof(uint32_t), "stats must be whole words");
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "shared memory counters need lock free atomics");
+
+/**
+ * Layout of the shared memory segment, the stats words are guarded by a seqlock: the writer makes the sequence odd
+ * while it copies and even again when it is done, readers retry until they see the same even sequence on both
+ * sides of their copy, so the writer never waits for a reader
+ */
+struct StatsBlock {
+    uint32_t magic_;
+    uint32_t version_;
+    std::atomic<uint32_t> sequence_;
+    std::atomic<uint32_t> words_[kSessionStatsWords];
+};
+
+static const uint32_t kStatsMagic = 0x46425354;
+static const uint32_t kStatsVersion = 1;
+// every game process publishes to <prefix><pid>
+static const char kStatsNamePrefix[] = "/flappy-bird-";
+
+/**
+ * The shared memory name a game process publishes its stats under
+ * @param pid
+ */
+std::string StatsSegmentName(uint32_t pid);
+
+/**
+ * The id of this process, 0 where there is no POSIX getpid
+ */
+uint32_t CurrentProcessId();
+
+/**
+ * Turns per tick timings and deaths into the rate and percentile fields of SessionStats
+ * Percentiles are only recomputed every kPercentileInterval ticks so the per tick cost stays flat
+ */
+class SessionStatsTracker {
+  public:
+    SessionStatsTracker();
+
+    /**
+     * Records one simulation tick
+     * @param now_us a monotonic timestamp in microseconds
+     * @param frame_time_us how long the tick took
+     * @param died whether the run has ended in a death after the tick, the tick it starts being true counts as a death
+     */
+    void RecordTick(uint64_t now_us, float frame_time_us, bool died);
+
+    /**
+     * Copies the tracked fields into stats, the game fields are left alone
+     * @param stats
+     */
+    void Fill(SessionStats &stats) const;
+
+    static const size_t kFrameTimeSamples = 1024;
+    static const size_t kPercentileInterval = 64;
+    static const size_t kDeathBuckets = 60;
+
+  private:
+    void UpdatePercentiles();
+
+    // ring buffer of the latest tick times and a scratch copy that nth_element can reorder
+    std::vector<float> frame_times_;
+    std::vector<float> sorted_frame_times_;
+    size_t next_frame_time_ = 0;
+    size_t num_frame_times_ = 0;
+    size_t ticks_since_percentiles_ = 0;
+    float frame_time_p50_us_ = 0;
+    float frame_time_p90_us_ = 0;
+    float frame_time_p99_us_ = 0;
+    float frame_time_max_us_ = 0;
+
+    // deaths counted per second over the last minute
+    uint32_t death_buckets_[kDeathBuckets] = {};
+    uint64_t current_second_ = 0;
+    uint32_t deaths_ = 0;
+    uint32_t deaths_last_minute_ = 0;
+    bool was_dead_ = false;
+
+    // ticks are counted per wall clock second and the rate is the count of the last full second
+    uint64_t rate_window_start_us_ = 0;
+    uint32_t ticks_in_window_ = 0;
+    float ticks_per_second_ = 0;
+    bool started_ = false;
+};
+
+/**
+ * Owns the shared memory segment of this process and writes stats into it
+ * Only available on POSIX systems, Open() fails elsewhere
+ */
+class StatsPublisher {
+  public:
+    StatsPublisher() = default;
+    ~StatsPublisher();
+    StatsPublisher(const StatsPublisher &) = delete;
+    StatsPublisher &operator=(const StatsPublisher &) = delete;
+
+    /**
+     * Creates or reuses the named segment and maps it
+     * @param name a POSIX shared memory name starting with /
+     * @return false if the segment could not be created
+     */
+    bool Open(const std::string &name);
+
+    /**
+     * Unmaps and removes the segment
+     */
+    void Close();
+
+    bool IsOpen() const;
+
+    /**
+     * Writes one set of stats under the seqlock, never blocks and never allocates
+     * Should only be called from one thread
+     * @param stats
+     */
+    void Publish(const SessionStats &stats);
+
+  private:
+    StatsBlock *block_ = nullptr;
+    std::string name_;
+};
+
+/**
+ * Read only view of another process's stats segment
+ */
+class StatsReader {
+  public:
+    StatsReader() = default;
+    ~StatsReader();
+    StatsReader(const StatsReader &) = delete;
+    StatsReader &operator=(const StatsReader &) = delete;
+    StatsReader(StatsReader &&other) noexcept;
+    StatsReader &operator=(StatsReader &&other) noexcept;
+
+    /**
+     * Maps the named segment and checks its header
+     * @param name
+     * @return false if there is no stats segment with that name
+     */
+    bool Open(const std::string &name);
+
+    void Close();
+
+    /**
+     * Takes a consistent copy of the stats, retrying while the writer is in the middle of an update
+     * @param stats
+     * @return false if no consistent copy could be taken within kMaxReadAttempts
+     */
+    bool Read(SessionStats &stats) const;
+
+    static const size_t kMaxReadAttempts = 1000;
+
+  private:
+    const StatsBlock *block_ = nullptr;
+};
+} // namespace flappybird
@@ -0,0 +1,88 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "spectator_state.h"
+#include "triple_buffer.h"
+
+namespace flappybird {
+/**
+ * Streams the per tick game state to any number of local viewers over loopback TCP
+ * The game thread only hands states over through Publish(), all socket work happens on the server's own thread
+ * which encodes each tick once as a delta frame and fans the same bytes out to every subscriber with epoll
+ * Only available on Linux, Start() fails elsewhere
+ */
+class SpectatorServer {
+  public:
+    SpectatorServer();
+    ~SpectatorServer();
+    SpectatorServer(const SpectatorServer &) = delete;
+    SpectatorServer &operator=(const SpectatorServer &) = delete;
+
+    /**
+     * Listens on 127.0.0.1 and starts the fan-out thread
+     * @param port the port to listen on, 0 picks a free one
+     * @return false if the socket could not be set up
+     */
+    bool Start(uint16_t port);
+
+    /**
+     * Disconnects every subscriber and stops the fan-out thread
+     */
+    void Stop();
+
+    /**
+     * Hands the state of one tick to the fan-out thread, never blocks on subscribers
+     * Should only be called from one thread
+     * @param tick 
+     * @param state 
+     */
+    void Publish(uint32_t tick, const SpectatorState &state);
+
+    bool IsRunning() const;
+    uint16_t GetPort() const;
+    size_t GetSubscriberCount() const;
+
+    // a subscriber that falls this far behind is disconnected instead of buffering without bound
+    static const size_t kMaxPendingBytes = 64 * 1024;
+
+  private:
+    struct TickState {
+        uint32_t tick_ = 0;
+        SpectatorState state_;
+    };
+
+    struct Subscriber {
+        std::vector<uint8_t> pending_;
+        size_t pending_offset_ = 0;
+    };
+
+    /**
+     * Fan-out thread loop, accepts subscribers and broadcasts every published tick
+     */
+    void Run();
+    void AcceptSubscribers();
+    void BroadcastLatest();
+    void SendTo(int fd, Subscriber &subscriber, const uint8_t *data, size_t size);
+    void FlushPending(int fd, Subscriber &subscriber);
+    void Disconnect(int fd);
+
+    TripleBuffer<TickState> published_;
+    std::atomic<bool> running_{false};
+    std::atomic<size_t> subscriber_count_{0};
+    std::thread thread_;
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+    uint16_t port_ = 0;
+
+    // only touched by the fan-out thread
+    std::unordered_map<int, Subscriber> subscribers_;
+    std::vector<int> disconnected_;
+    TickState last_sent_;
+    bool has_sent_ = false;
+    uint8_t frame_[kMaxSpectatorFrameSize];
+};
+} // namespace flappybird
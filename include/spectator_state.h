@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace flappybird {
+/**
+ * Per tick game state streamed to spectators
+ * Every field is exactly one 32 bit word so frames can be delta compressed word by word
+ */
+struct SpectatorState {
+    static const size_t kMaxObstacles = 8;
+
+    struct Gap {
+        float x_ = 0;
+        float gap_top_ = 0;
+        float gap_bottom_ = 0;
+    };
+
+    uint32_t game_state_ = 0;
+    uint32_t score_ = 0;
+    float bird_x_ = 0;
+    float bird_y_ = 0;
+    float bird_velocity_ = 0;
+    uint32_t num_obstacles_ = 0;
+    Gap obstacles_[kMaxObstacles];
+};
+
+/**
+ * Wire format for spectator frames, all words are in host byte order since the stream never leaves the machine
+ * A frame is a header followed by one word for every bit set in the mask, in word order
+ * The mask says which words of the state changed since the previous frame, a keyframe has every bit set
+ */
+struct SpectatorFrameHeader {
+    uint32_t tick_;
+    uint32_t mask_;
+};
+
+static const size_t kSpectatorStateWords = sizeof(SpectatorState) / sizeof(uint32_t);
+static const size_t kMaxSpectatorFrameSize = sizeof(SpectatorFrameHeader) + sizeof(SpectatorState);
+static_assert(kSpectatorStateWords <= 32, "each state word needs a bit in the frame mask");
+
+/**
+ * Writes a frame holding only the words of current that differ from previous
+ * @param tick the simulation tick the state belongs to
+ * @param previous the state the receiver already has
+ * @param current the state to send
+ * @param out buffer of at least kMaxSpectatorFrameSize bytes
+ * @return the number of bytes written
+ */
+size_t EncodeSpectatorDelta(uint32_t tick, const SpectatorState &previous, const SpectatorState &current,
+                            uint8_t *out);
+
+/**
+ * Writes a frame holding every word of the state, sent to subscribers that have nothing to apply a delta to
+ * @return the number of bytes written
+ */
+size_t EncodeSpectatorKeyframe(uint32_t tick, const SpectatorState &state, uint8_t *out);
+
+/**
+ * Applies the frame at the start of data to state
+ * @param data received bytes
+ * @param size number of received bytes
+ * @param state the reconstructed state, updated in place
+ * @param tick set to the tick of the decoded frame
+ * @return the number of bytes the frame used, or 0 if data does not hold a complete frame yet
+ */
+size_t DecodeSpectatorFrame(const uint8_t *data, size_t size, SpectatorState &state, uint32_t &tick);
+} // namespace flappybird
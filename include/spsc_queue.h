@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+namespace flappybird {
+/**
+ * Bounded lock-free queue with exactly one producer thread and one consumer thread
+ * Used to forward input events from the window thread to the simulation thread
+ * @tparam T the element type, it must be default constructible and copyable
+ * @tparam Capacity the number of slots, must be a power of two
+ */
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+  public:
+    SpscQueue() = default;
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    /**
+     * Adds an element to the back of the queue
+     * @param value 
+     * @return false if the queue is full and the element was dropped
+     */
+    bool Push(const T &value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        slots_[tail & (Capacity - 1)] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Removes the element at the front of the queue
+     * @param value is set to the removed element
+     * @return false if the queue was empty
+     */
+    bool Pop(T &value) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = slots_[head & (Capacity - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+  private:
+    static const size_t kCacheLineSize = 64;
+
+    T slots_[Capacity];
+    // head and tail are padded onto separate cache lines so the two threads don't false share
+    std::atomic<size_t> head_{0};
+    char head_padding_[kCacheLineSize];
+    std::atomic<size_t> tail_{0};
+};
+} // namespace flappybird
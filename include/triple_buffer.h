@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace flappybird {
+/**
+ * Lock-free triple buffer for handing snapshots from one writer thread to one reader thread
+ * The writer fills the back slot and publishes it, the reader swaps in the newest published slot
+ * Neither side ever waits on the other, the reader just keeps its last slot until a newer one arrives
+ * @tparam T the snapshot type, slots are reused so T should be a value type that keeps its storage between fills
+ */
+template <typename T>
+class TripleBuffer {
+  public:
+    TripleBuffer() = default;
+    TripleBuffer(const TripleBuffer &) = delete;
+    TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+    /**
+     * The slot the writer may fill, it belongs to the writer until the next Publish()
+     */
+    T &GetWriteSlot() {
+        return slots_[write_index_];
+    }
+
+    /**
+     * Makes the write slot the newest snapshot and hands the writer a free slot
+     */
+    void Publish() {
+        uint8_t previous = middle_index_.exchange(write_index_ | kFreshBit, std::memory_order_acq_rel);
+        write_index_ = previous & kIndexMask;
+    }
+
+    /**
+     * Swaps in the newest published snapshot if there is one
+     * @return true if the read slot changed
+     */
+    bool Update() {
+        if ((middle_index_.load(std::memory_order_relaxed) & kFreshBit) == 0) {
+            return false;
+        }
+        uint8_t previous = middle_index_.exchange(read_index_, std::memory_order_acq_rel);
+        read_index_ = previous & kIndexMask;
+        return true;
+    }
+
+    /**
+     * The slot the reader may use, it belongs to the reader until the next Update()
+     */
+    const T &GetReadSlot() const {
+        return slots_[read_index_];
+    }
+
+  private:
+    static const uint8_t kIndexMask = 3;
+    static const uint8_t kFreshBit = 4;
+    static const size_t kCacheLineSize = 64;
+
+    T slots_[3];
+    // the indices are padded onto separate cache lines so the two threads don't false share
+    uint8_t write_index_ = 0;
+    char write_padding_[kCacheLineSize];
+    std::atomic<uint8_t> middle_index_{1};
+    char middle_padding_[kCacheLineSize];
+    uint8_t read_index_ = 2;
+};
+} // namespace flappybird
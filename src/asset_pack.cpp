@@ -0,0 +1,261 @@
+#include <cstdio>
+#include <cstring>
+#include <asset_pack.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace flappybird {
+
+AssetPack::~AssetPack() {
+    Close();
+}
+
+bool AssetPack::IsOpen() const {
+    return mapping_ != nullptr;
+}
+
+const BakedFont *AssetPack::FindFont(const std::string &name, float size) const {
+    for (size_t i = 0; i < font_count_; i++) {
+        if (fonts_[i].size_ == size && name.compare(0, sizeof(fonts_[i].name_), fonts_[i].name_) == 0) {
+            return &fonts_[i];
+        }
+    }
+    return nullptr;
+}
+
+const BakedGlyph *AssetPack::GetGlyph(const BakedFont &font, char character) const {
+    uint32_t code = static_cast<unsigned char>(character);
+    if (code < font.first_char_ || code - font.first_char_ >= font.glyph_count_) {
+        return nullptr;
+    }
+    return &glyphs_[font.first_glyph_ + code - font.first_char_];
+}
+
+const uint8_t *AssetPack::GetAtlas(const BakedFont &font) const {
+    return pixels_ + font.pixel_offset_;
+}
+
+size_t AssetPack::GetReachabilityCount() const {
+    return reachability_count_;
+}
+
+const BakedReachability &AssetPack::GetReachability(size_t index) const {
+    return reachability_[index];
+}
+
+const uint64_t *AssetPack::GetReachableBits(const BakedReachability &table) const {
+    return reachable_bits_ + table.first_word_;
+}
+
+const int16_t *AssetPack::GetNextRanges(const BakedReachability &table) const {
+    return next_ranges_ + table.first_range_;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+bool AssetPack::Open(const std::string &path, std::string &error) {
+    Close();
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = "can't open " + path;
+        return false;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(AssetPackHeader)) {
+        close(fd);
+        error = path + " is too short to be an asset pack";
+        return false;
+    }
+    size_t size = static_cast<size_t>(file_stat.st_size);
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        error = "can't map " + path;
+        return false;
+    }
+    mapping_ = mapping;
+    mapping_size_ = size;
+
+    // problems are collected separately since error may hold something from an earlier call
+    std::string problem;
+    const char *bytes = static_cast<const char *>(mapping);
+    const AssetPackHeader *header = static_cast<const AssetPackHeader *>(mapping);
+    if (std::memcmp(header->magic_, kAssetPackMagic, sizeof(kAssetPackMagic)) != 0) {
+        problem = path + " is not an asset pack";
+    } else if (header->version_ != kAssetPackVersion) {
+        problem = path + " is asset pack version " + std::to_string(header->version_) + ", expected " +
+                  std::to_string(kAssetPackVersion);
+    } else if (header->section_count_ > (size - sizeof(AssetPackHeader)) / sizeof(AssetSection)) {
+        problem = path + " has a truncated section table";
+    } else {
+        const AssetSection *sections = reinterpret_cast<const AssetSection *>(bytes + sizeof(AssetPackHeader));
+        for (uint32_t i = 0; i < header->section_count_ && problem.empty(); i++) {
+            const AssetSection &section = sections[i];
+            if (section.offset_ > size || section.size_ > size - section.offset_ ||
+                section.offset_ % kAssetAlignment != 0) {
+                problem = path + " has a section outside the file";
+            } else if (section.kind_ == FontSection && section.size_ == section.count_ * sizeof(BakedFont)) {
+                fonts_ = reinterpret_cast<const BakedFont *>(bytes + section.offset_);
+                font_count_ = section.count_;
+            } else if (section.kind_ == GlyphSection && section.size_ == section.count_ * sizeof(BakedGlyph)) {
+                glyphs_ = reinterpret_cast<const BakedGlyph *>(bytes + section.offset_);
+                glyph_count_ = section.count_;
+            } else if (section.kind_ == PixelSection) {
+                pixels_ = reinterpret_cast<const uint8_t *>(bytes + section.offset_);
+                pixel_count_ = section.size_;
+            } else if (section.kind_ == ReachabilitySection &&
+                       section.size_ == section.count_ * sizeof(BakedReachability)) {
+                reachability_ = reinterpret_cast<const BakedReachability *>(bytes + section.offset_);
+                reachability_count_ = section.count_;
+            } else if (section.kind_ == ReachableBitsSection && section.size_ == section.count_ * sizeof(uint64_t)) {
+                reachable_bits_ = reinterpret_cast<const uint64_t *>(bytes + section.offset_);
+                reachable_bit_count_ = section.count_;
+            } else if (section.kind_ == NextRangeSection && section.size_ == section.count_ * sizeof(int16_t)) {
+                next_ranges_ = reinterpret_cast<const int16_t *>(bytes + section.offset_);
+                next_range_count_ = section.count_;
+            } else if (section.kind_ == FontSection || section.kind_ == GlyphSection ||
+                       section.kind_ == ReachabilitySection || section.kind_ == ReachableBitsSection ||
+                       section.kind_ == NextRangeSection) {
+                problem = path + " has a section of the wrong size";
+            }
+        }
+        // every font has to point inside the glyph and pixel sections, after this drawing needs no checks
+        for (size_t i = 0; i < font_count_ && problem.empty(); i++) {
+            const BakedFont &font = fonts_[i];
+            if (font.first_glyph_ > glyph_count_ || font.glyph_count_ > glyph_count_ - font.first_glyph_ ||
+                font.pixel_offset_ > pixel_count_ ||
+                static_cast<uint64_t>(font.atlas_width_) * font.atlas_height_ > pixel_count_ - font.pixel_offset_) {
+                problem = path + " has a font that points outside the pack";
+            }
+        }
+        // and every reachability table inside the bits and range sections
+        for (size_t i = 0; i < reachability_count_ && problem.empty(); i++) {
+            const BakedReachability &table = reachability_[i];
+            if (table.first_word_ > reachable_bit_count_ ||
+                table.word_count_ > reachable_bit_count_ - table.first_word_ ||
+                table.first_range_ > next_range_count_ || table.range_count_ > next_range_count_ - table.first_range_) {
+                problem = path + " has a reachability table that points outside the pack";
+            }
+        }
+        if (problem.empty()) {
+            return true;
+        }
+    }
+    error = problem;
+    Close();
+    return false;
+}
+
+void AssetPack::Close() {
+    if (mapping_ != nullptr) {
+        munmap(mapping_, mapping_size_);
+    }
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+    fonts_ = nullptr;
+    font_count_ = 0;
+    glyphs_ = nullptr;
+    glyph_count_ = 0;
+    pixels_ = nullptr;
+    pixel_count_ = 0;
+    reachability_ = nullptr;
+    reachability_count_ = 0;
+    reachable_bits_ = nullptr;
+    reachable_bit_count_ = 0;
+    next_ranges_ = nullptr;
+    next_range_count_ = 0;
+}
+
+#else
+
+bool AssetPack::Open(const std::string &path, std::string &error) {
+    error = "memory mapped asset packs need a POSIX system";
+    return false;
+}
+
+void AssetPack::Close() {
+}
+
+#endif
+
+void AssetPackWriter::AddFont(const std::string &name, float size, float baseline_offset,
+                              const std::vector<BakedGlyph> &glyphs, uint32_t atlas_width, uint32_t atlas_height,
+                              const std::vector<uint8_t> &atlas) {
+    BakedFont font = {};
+    std::strncpy(font.name_, name.c_str(), sizeof(font.name_) - 1);
+    font.size_ = size;
+    font.baseline_offset_ = baseline_offset;
+    font.first_char_ = kFirstBakedChar;
+    font.first_glyph_ = glyphs_.size();
+    font.glyph_count_ = glyphs.size();
+    font.atlas_width_ = atlas_width;
+    font.atlas_height_ = atlas_height;
+    // every atlas starts aligned so it can be handed to the GPU straight from the mapping
+    pixels_.resize((pixels_.size() + kAssetAlignment - 1) / kAssetAlignment * kAssetAlignment);
+    font.pixel_offset_ = pixels_.size();
+    fonts_.push_back(font);
+    glyphs_.insert(glyphs_.end(), glyphs.begin(), glyphs.end());
+    pixels_.insert(pixels_.end(), atlas.begin(), atlas.begin() + atlas_width * atlas_height);
+}
+
+void AssetPackWriter::AddReachability(const FlightPhysics &physics, const std::vector<uint64_t> &reachable,
+                                      const std::vector<int16_t> &next_ranges, uint32_t unused_transitions) {
+    BakedReachability table;
+    table.physics_ = physics;
+    table.first_word_ = reachable_bits_.size();
+    table.word_count_ = reachable.size();
+    table.first_range_ = next_ranges_.size();
+    table.range_count_ = next_ranges.size();
+    table.unused_transitions_ = unused_transitions;
+    reachability_.push_back(table);
+    reachable_bits_.insert(reachable_bits_.end(), reachable.begin(), reachable.end());
+    next_ranges_.insert(next_ranges_.end(), next_ranges.begin(), next_ranges.end());
+}
+
+bool AssetPackWriter::Write(const std::string &path) const {
+    struct Blob {
+        uint32_t kind_;
+        uint32_t count_;
+        const void *data_;
+        size_t size_;
+    };
+    const Blob blobs[] = {
+        {FontSection, static_cast<uint32_t>(fonts_.size()), fonts_.data(), fonts_.size() * sizeof(BakedFont)},
+        {GlyphSection, static_cast<uint32_t>(glyphs_.size()), glyphs_.data(), glyphs_.size() * sizeof(BakedGlyph)},
+        {PixelSection, static_cast<uint32_t>(pixels_.size()), pixels_.data(), pixels_.size()},
+        {ReachabilitySection, static_cast<uint32_t>(reachability_.size()), reachability_.data(),
+         reachability_.size() * sizeof(BakedReachability)},
+        {ReachableBitsSection, static_cast<uint32_t>(reachable_bits_.size()), reachable_bits_.data(),
+         reachable_bits_.size() * sizeof(uint64_t)},
+        {NextRangeSection, static_cast<uint32_t>(next_ranges_.size()), next_ranges_.data(),
+         next_ranges_.size() * sizeof(int16_t)}
+    };
+    const uint32_t section_count = sizeof(blobs) / sizeof(blobs[0]);
+
+    AssetPackHeader header;
+    std::memcpy(header.magic_, kAssetPackMagic, sizeof(kAssetPackMagic));
+    header.version_ = kAssetPackVersion;
+    header.section_count_ = section_count;
+    std::vector<char> pack(sizeof(header) + section_count * sizeof(AssetSection));
+    std::memcpy(pack.data(), &header, sizeof(header));
+    for (uint32_t i = 0; i < section_count; i++) {
+        pack.resize((pack.size() + kAssetAlignment - 1) / kAssetAlignment * kAssetAlignment);
+        AssetSection section = {blobs[i].kind_, blobs[i].count_, pack.size(), blobs[i].size_};
+        std::memcpy(pack.data() + sizeof(header) + i * sizeof(AssetSection), &section, sizeof(section));
+        const char *data = static_cast<const char *>(blobs[i].data_);
+        pack.insert(pack.end(), data, data + blobs[i].size_);
+    }
+
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool written = std::fwrite(pack.data(), 1, pack.size(), file) == pack.size();
+    return std::fclose(file) == 0 && written;
+}
+} // namespace flappybird
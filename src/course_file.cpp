@@ -0,0 +1,236 @@
+#include <cstring>
+#include <sstream>
+#include <utility>
+#include <course_file.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace flappybird {
+
+const size_t CourseFile::kReleaseStep;
+
+CourseFile::~CourseFile() {
+    Close();
+}
+
+CourseFile::CourseFile(CourseFile &&other) noexcept {
+    *this = std::move(other);
+}
+
+CourseFile &CourseFile::operator=(CourseFile &&other) noexcept {
+    if (this != &other) {
+        Close();
+        std::swap(mapping_, other.mapping_);
+        std::swap(mapping_size_, other.mapping_size_);
+        std::swap(pipes_, other.pipes_);
+        std::swap(pipe_count_, other.pipe_count_);
+        std::swap(released_bytes_, other.released_bytes_);
+    }
+    return *this;
+}
+
+bool CourseFile::IsOpen() const {
+    return mapping_ != nullptr;
+}
+
+size_t CourseFile::GetPipeCount() const {
+    return pipe_count_;
+}
+
+const CoursePipe &CourseFile::GetPipe(size_t index) const {
+    return pipes_[index];
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+bool CourseFile::Open(const std::string &path, std::string &error) {
+    Close();
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = "can't open " + path;
+        return false;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(CourseHeader)) {
+        close(fd);
+        error = path + " is too short to be a course";
+        return false;
+    }
+    size_t size = static_cast<size_t>(file_stat.st_size);
+    // the mapping keeps the file alive, so the descriptor isn't needed past this point
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        error = "can't map " + path;
+        return false;
+    }
+
+    const CourseHeader *header = static_cast<const CourseHeader *>(mapping);
+    size_t max_pipes = (size - sizeof(CourseHeader)) / sizeof(CoursePipe);
+    if (std::memcmp(header->magic_, kCourseMagic, sizeof(kCourseMagic)) != 0) {
+        error = path + " is not a course file";
+    } else if (header->version_ != kCourseVersion) {
+        error = path + " is course version " + std::to_string(header->version_) + ", expected " +
+                std::to_string(kCourseVersion);
+    } else if (header->record_size_ != sizeof(CoursePipe)) {
+        error = path + " has " + std::to_string(header->record_size_) + " byte pipes, expected " +
+                std::to_string(sizeof(CoursePipe));
+    } else if (header->pipe_count_ > max_pipes ||
+               sizeof(CourseHeader) + header->pipe_count_ * sizeof(CoursePipe) != size) {
+        error = path + " is truncated or has trailing bytes";
+    } else {
+        mapping_ = mapping;
+        mapping_size_ = size;
+        pipes_ = reinterpret_cast<const CoursePipe *>(static_cast<const char *>(mapping) + sizeof(CourseHeader));
+        pipe_count_ = static_cast<size_t>(header->pipe_count_);
+        released_bytes_ = 0;
+        // courses are read front to back, so the kernel can read ahead aggressively
+        madvise(mapping_, mapping_size_, MADV_SEQUENTIAL);
+        return true;
+    }
+    munmap(mapping, size);
+    return false;
+}
+
+void CourseFile::Close() {
+    if (mapping_ != nullptr) {
+        munmap(mapping_, mapping_size_);
+    }
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+    pipes_ = nullptr;
+    pipe_count_ = 0;
+    released_bytes_ = 0;
+}
+
+void CourseFile::ReleaseBefore(size_t index) {
+    if (mapping_ == nullptr) {
+        return;
+    }
+    size_t end = sizeof(CourseHeader) + index * sizeof(CoursePipe);
+    if (end < released_bytes_ + kReleaseStep) {
+        return;
+    }
+    // the header page is released along with the first pipes, it is only read by Open
+    size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    end -= end % page_size;
+    // the mapping is read only and file backed, so dropped pages are simply read from the file again if needed
+    madvise(static_cast<char *>(mapping_) + released_bytes_, end - released_bytes_, MADV_DONTNEED);
+    released_bytes_ = end;
+}
+
+void CourseFile::Rewind() {
+    if (mapping_ == nullptr) {
+        return;
+    }
+    madvise(mapping_, mapping_size_, MADV_DONTNEED);
+    released_bytes_ = 0;
+}
+
+#else
+
+bool CourseFile::Open(const std::string &path, std::string &error) {
+    error = "memory mapped courses need a POSIX system";
+    return false;
+}
+
+void CourseFile::Close() {
+}
+
+void CourseFile::ReleaseBefore(size_t index) {
+}
+
+void CourseFile::Rewind() {
+}
+
+#endif
+
+// formats a limit without trailing zeros for error messages
+static std::string FormatLimit(float limit) {
+    std::ostringstream text;
+    text << limit;
+    return text.str();
+}
+
+bool ValidateCoursePipe(const CoursePipe &pipe, std::string &error) {
+    // written so that NaN fails every check
+    if (!(pipe.spacing_ >= kCourseMinSpacing && pipe.spacing_ >= pipe.width_)) {
+        error = "pipes must be at least " + FormatLimit(kCourseMinSpacing) + " apart and must not overlap";
+    } else if (!(pipe.width_ >= kCourseMinWidth && pipe.width_ <= kCourseMaxWidth)) {
+        error = "width must be between " + FormatLimit(kCourseMinWidth) + " and " +
+                FormatLimit(kCourseMaxWidth);
+    } else if (!(pipe.gap_size_ >= kCourseMinGap)) {
+        error = "gap must be at least " + FormatLimit(kCourseMinGap);
+    } else if (!(pipe.gap_bottom_ - pipe.gap_size_ >= 0 && pipe.gap_bottom_ <= kCourseFieldHeight)) {
+        error = "gap must lie inside the playfield";
+    } else if (!(pipe.speed_ > 0 && pipe.speed_ <= kCourseMaxSpeed)) {
+        error = "speed must be above 0 and at most " + FormatLimit(kCourseMaxSpeed);
+    } else if (pipe.color_ > 0xffffff) {
+        error = "color must be six hex digits";
+    } else {
+        return true;
+    }
+    return false;
+}
+
+bool ParseCoursePipe(const std::string &line, CoursePipe &pipe) {
+    std::istringstream fields(line);
+    std::string first;
+    if (!(fields >> first) || first[0] == '#') {
+        return false;
+    }
+    fields.clear();
+    fields.seekg(0);
+    if (!(fields >> pipe.spacing_ >> pipe.gap_bottom_ >> pipe.gap_size_ >> pipe.width_ >> pipe.speed_ >>
+          std::hex >> pipe.color_)) {
+        return false;
+    }
+    std::string rest;
+    return !(fields >> rest);
+}
+
+CourseWriter::~CourseWriter() {
+    if (file_ != nullptr) {
+        std::fclose(file_);
+    }
+}
+
+static bool WriteCourseHeader(std::FILE *file, uint64_t pipe_count) {
+    CourseHeader header;
+    std::memcpy(header.magic_, kCourseMagic, sizeof(kCourseMagic));
+    header.version_ = kCourseVersion;
+    header.record_size_ = sizeof(CoursePipe);
+    header.pipe_count_ = pipe_count;
+    return std::fwrite(&header, sizeof(header), 1, file) == 1;
+}
+
+bool CourseWriter::Open(const std::string &path) {
+    file_ = std::fopen(path.c_str(), "wb");
+    pipe_count_ = 0;
+    // the count is patched in by Finish, a course that is never finished stays invalid
+    return file_ != nullptr && WriteCourseHeader(file_, UINT64_MAX);
+}
+
+bool CourseWriter::Write(const CoursePipe &pipe) {
+    if (file_ == nullptr || std::fwrite(&pipe, sizeof(pipe), 1, file_) != 1) {
+        return false;
+    }
+    pipe_count_++;
+    return true;
+}
+
+bool CourseWriter::Finish() {
+    if (file_ == nullptr) {
+        return false;
+    }
+    bool written = std::fseek(file_, 0, SEEK_SET) == 0 && WriteCourseHeader(file_, pipe_count_);
+    written = std::fclose(file_) == 0 && written;
+    file_ = nullptr;
+    return written;
+}
+} // namespace flappybird
@@ -1,29 +1,245 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
 #include <flappy_bird_app.h>
 
 namespace flappybird {
+
+using std::chrono::steady_clock;
+using std::chrono::duration;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+
+// taken during static initialization, before CINDER_APP's main runs, so startup times include creating the window
+static const steady_clock::time_point kLaunchTime = steady_clock::now();
+
+static double MillisecondsSinceLaunch() {
+    return duration<double, std::milli>(steady_clock::now() - kLaunchTime).count();
+}
+
+// reads a command line number, false unless the whole argument is a non-negative whole number
+static bool ParseCountArgument(const string &text, unsigned long &value) {
+    char *end = nullptr;
+    errno = 0;
+    long parsed = std::strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || errno == ERANGE || parsed < 0) {
+        return false;
+    }
+    value = static_cast<unsigned long>(parsed);
+    return true;
+}
+
 FlappyBirdApp::FlappyBirdApp()  {
     ci::app::setWindowSize(kWindowSize, kWindowSize);
 }
 
-// creates the background and makes the game engine display
+FlappyBirdApp::~FlappyBirdApp() {
+    StopSimulation();
+}
+
+// starts the spectator server, loads a course and fills the flock if asked to, loads fonts and reachability tables from
+// the asset pack, opens the live stats segment, starts building the tables the pack lacks, publishes the first snapshot
+// and starts the simulation thread
+void FlappyBirdApp::setup() {
+    string asset_path = (getAppPath() / kDefaultAssetPack).string();
+    size_t num_players = 0;
+    size_t num_bots = 0;
+    const vector<string> &arguments = getCommandLineArgs();
+    for (size_t i = 0; i + 1 < arguments.size(); i++) {
+        if (arguments[i] == kAssetsArgument) {
+            asset_path = arguments[i + 1];
+        }
+        unsigned long count = 0;
+        bool is_count = ParseCountArgument(arguments[i + 1], count);
+        if (arguments[i] == kPlayersArgument) {
+            if (is_count) {
+                num_players = std::min<size_t>(count, kPlayerKeys.size());
+            } else {
+                ci::app::console() << "Not a number of players: " << arguments[i + 1] << std::endl;
+            }
+        }
+        if (arguments[i] == kBotsArgument) {
+            if (is_count) {
+                num_bots = std::min<size_t>(count, kMaxBots);
+            } else {
+                ci::app::console() << "Not a number of bots: " << arguments[i + 1] << std::endl;
+            }
+        }
+        if (arguments[i] == kSpectateArgument) {
+            if (!is_count || count > UINT16_MAX) {
+                ci::app::console() << "Not a port to spectate on: " << arguments[i + 1] << std::endl;
+                continue;
+            }
+            uint16_t port = static_cast<uint16_t>(count);
+            if (spectator_server_.Start(port)) {
+                ci::app::console() << "Spectators can connect on port " << spectator_server_.GetPort() << std::endl;
+            } else {
+                ci::app::console() << "Could not start the spectator server on port " << port << std::endl;
+            }
+        }
+        if (arguments[i] == kSubmissionsArgument) {
+            submissions_path_ = arguments[i + 1];
+        }
+        if (arguments[i] == kCourseArgument) {
+            string error;
+            if (!game_engine_.LoadCourse(arguments[i + 1], error)) {
+                ci::app::console() << "Could not load the course: " << error << std::endl;
+            }
+        }
+    }
+    AddFlock(num_players, num_bots);
+    // without a pack every font is loaded through cinder, which works but is what makes startup slow
+    string error;
+    if (!asset_pack_.Open(asset_path, error)) {
+        ci::app::console() << "Loading fonts without baked assets: " << error << std::endl;
+    }
+    ReachabilityTable::LoadBaked(asset_pack_);
+    game_engine_.LoadFonts(&asset_pack_);
+    session_stats_.pid_ = CurrentProcessId();
+    if (!stats_publisher_.Open(StatsSegmentName(session_stats_.pid_))) {
+        ci::app::console() << "Could not publish live stats" << std::endl;
+    }
+    game_engine_.WriteSnapshot(snapshots_.GetWriteSlot());
+    snapshots_.Publish();
+    vector<FlightPhysics> spawn_physics = {game_engine_.GetFlightPhysics(GameEngine::Normal),
+                                           game_engine_.GetFlightPhysics(GameEngine::Challenge)};
+    reachability_thread_ = std::thread([spawn_physics] {
+        for (const FlightPhysics &physics : spawn_physics) {
+            ReachabilityTable::Get(physics);
+        }
+    });
+    running_ = true;
+    simulation_thread_ = std::thread(&FlappyBirdApp::RunSimulation, this);
+    ci::app::console() << "Setup finished " << MillisecondsSinceLaunch() << " ms after launch" << std::endl;
+}
+
+void FlappyBirdApp::AddFlock(size_t num_players, size_t num_bots) {
+    for (size_t i = 0; i < num_players; i++) {
+        game_engine_.AddFlockBird(kPlayerKeys[i], nullptr, Color(kPlayerColors[i]));
+    }
+    for (size_t i = 0; i < num_bots; i++) {
+        float margin = kMinBotMargin + (kMaxBotMargin - kMinBotMargin) * i / num_bots;
+        game_engine_.AddFlockBird(Flock::kNoKey, std::make_shared<GapFollower>(margin), Color(kBotColor));
+    }
+    if (num_players + num_bots > 0) {
+        ci::app::console() << "Flying " << num_players << " players and " << num_bots << " bots" << std::endl;
+    }
+}
+
+void FlappyBirdApp::cleanup() {
+    StopSimulation();
+}
+
+void FlappyBirdApp::StopSimulation() {
+    running_ = false;
+    if (simulation_thread_.joinable()) {
+        simulation_thread_.join();
+    }
+    if (reachability_thread_.joinable()) {
+        reachability_thread_.join();
+    }
+    spectator_server_.Stop();
+    stats_publisher_.Close();
+}
+
+void FlappyBirdApp::RunSimulation() {
+    steady_clock::time_point next_tick = steady_clock::now();
+    GameEngine::InputEvent input;
+    while (running_) {
+        steady_clock::time_point tick_start = steady_clock::now();
+        while (input_queue_.Pop(input)) {
+            game_engine_.HandleInput(input);
+        }
+        bool was_playing = game_engine_.GetGameState() == GameEngine::GameScreen;
+        game_engine_.AdvanceOneFrame();
+        if (was_playing && game_engine_.GetGameState() == GameEngine::GameOverScreen) {
+            if (!game_engine_.GetCourseError().empty()) {
+                ci::app::console() << "Course run ended on a broken " << game_engine_.GetCourseError() << std::endl;
+            }
+            SubmitRun();
+        }
+        game_engine_.WriteSnapshot(snapshots_.GetWriteSlot());
+        snapshots_.Publish();
+        if (spectator_server_.IsRunning()) {
+            game_engine_.WriteSpectatorState(spectator_state_);
+            spectator_server_.Publish(tick_, spectator_state_);
+        }
+        if (stats_publisher_.IsOpen()) {
+            steady_clock::time_point tick_end = steady_clock::now();
+            stats_tracker_.RecordTick(duration_cast<microseconds>(tick_end.time_since_epoch()).count(), 
+                                      duration<float, std::micro>(tick_end - tick_start).count(),
+                                      game_engine_.HasDied());
+            game_engine_.WriteSessionStats(session_stats_);
+            stats_tracker_.Fill(session_stats_);
+            session_stats_.tick_ = tick_;
+            stats_publisher_.Publish(session_stats_);
+        }
+        tick_++;
+
+        // the tick rate can change with the selected mode, so it is read every tick
+        steady_clock::duration tick = duration_cast<steady_clock::duration>(
+                duration<double>(1 / game_engine_.GetTicksPerSecond()));
+        next_tick += tick;
+        steady_clock::time_point now = steady_clock::now();
+        if (now - next_tick > tick * kMaxTicksBehind) {
+            next_tick = now;
+        }
+        std::this_thread::sleep_until(next_tick);
+    }
+}
+
+void FlappyBirdApp::SubmitRun() {
+    Submission submission;
+    if (!MakeSubmission(game_engine_, submission)) {
+        return;
+    }
+    string line = FormatSubmission(submission);
+    if (submissions_path_.empty()) {
+        ci::app::console() << "Run: " << line << std::endl;
+        return;
+    }
+    std::ofstream submissions(submissions_path_, std::ios::app);
+    submissions << line << "\n";
+    if (!submissions) {
+        ci::app::console() << "Could not write the run to " << submissions_path_ << std::endl;
+    }
+}
+
+// creates the background and makes the game engine display the newest snapshot
 void FlappyBirdApp::draw() {
-    ci::Color background_color("dodgerblue"); 
-    ci::gl::clear(background_color);
-    game_engine_.Display();
+    ci::gl::clear(kBackgroundColor);
+    game_engine_.Display(snapshots_.GetReadSlot());
+    if (!first_frame_drawn_) {
+        // finish so the time covers the GPU work of the frame and not just issuing it
+        glFinish();
+        first_frame_drawn_ = true;
+        double first_frame_ms = MillisecondsSinceLaunch();
+        ci::app::console() << "First frame drawn " << first_frame_ms << " ms after launch, target "
+                           << kFirstFrameTargetMs << " ms" << (first_frame_ms > kFirstFrameTargetMs ? ", too slow" : "")
+                           << std::endl;
+    }
 }
 
-// advances the game one frame
+// picks up the newest snapshot, the game itself advances on the simulation thread
 void FlappyBirdApp::update() {
-    game_engine_.AdvanceOneFrame();
+    snapshots_.Update();
 }
 
 void FlappyBirdApp::keyDown(cinder::app::KeyEvent event) {
-    game_engine_.keyDown(event);
+    GameEngine::InputEvent input;
+    input.type_ = GameEngine::InputEvent::KeyPress;
+    input.key_code_ = event.getCode();
+    input_queue_.Push(input);
 }
 
 void FlappyBirdApp::mouseDown(cinder::app::MouseEvent event) {
-    game_engine_.mouseDown(event);
+    GameEngine::InputEvent input;
+    input.type_ = GameEngine::InputEvent::Click;
+    input.position_ = event.getPos();
+    input_queue_.Push(input);
 }
 
 }
-
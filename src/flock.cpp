@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <utility>
+#include <flock.h>
+
+namespace flappybird {
+
+const int Flock::kNoKey;
+
+GapFollower::GapFollower(float margin) : margin_(margin) {
+}
+
+bool GapFollower::ShouldFlap(const BirdObservation &observation) {
+    float target_y = observation.has_gap_ ? observation.gap_bottom_ - margin_
+                                          : (observation.gap_top_ + observation.gap_bottom_) / 2;
+    return observation.y_ > target_y;
+}
+
+size_t Flock::AddBird(int key_code, std::shared_ptr<BirdController> controller, uint32_t color, float y) {
+    y_.push_back(y);
+    velocity_.push_back(0);
+    started_.push_back(0);
+    crashed_.push_back(0);
+    landed_.push_back(0);
+    scores_.push_back(0);
+    colors_.push_back(color);
+    key_codes_.push_back(key_code);
+    controllers_.push_back(std::move(controller));
+    hits_.push_back(0);
+    crashed_this_tick_.reserve(y_.size());
+    num_alive_++;
+    return y_.size() - 1;
+}
+
+void Flock::Clear() {
+    y_.clear();
+    velocity_.clear();
+    started_.clear();
+    crashed_.clear();
+    landed_.clear();
+    scores_.clear();
+    colors_.clear();
+    key_codes_.clear();
+    controllers_.clear();
+    hits_.clear();
+    crashed_this_tick_.clear();
+    num_alive_ = 0;
+    num_flying_ = 0;
+    num_landed_ = 0;
+}
+
+void Flock::Reset(float y) {
+    std::fill(y_.begin(), y_.end(), y);
+    std::fill(velocity_.begin(), velocity_.end(), 0.0f);
+    std::fill(started_.begin(), started_.end(), 0);
+    std::fill(crashed_.begin(), crashed_.end(), 0);
+    std::fill(landed_.begin(), landed_.end(), 0);
+    std::fill(scores_.begin(), scores_.end(), 0);
+    crashed_this_tick_.clear();
+    num_alive_ = y_.size();
+    num_flying_ = 0;
+    num_landed_ = 0;
+}
+
+bool Flock::Flap(size_t index, float flap_velocity) {
+    if (crashed_[index] || landed_[index] || velocity_[index] <= flap_velocity / 2) {
+        return false;
+    }
+    if (!started_[index]) {
+        started_[index] = 1;
+        num_flying_++;
+    }
+    velocity_[index] = flap_velocity;
+    return true;
+}
+
+void Flock::RunControllers(BirdObservation observation, float flap_velocity) {
+    for (size_t i = 0; i < y_.size(); i++) {
+        if (controllers_[i] && !crashed_[i] && !landed_[i]) {
+            observation.y_ = y_[i];
+            observation.velocity_ = velocity_[i];
+            if (controllers_[i]->ShouldFlap(observation)) {
+                Flap(i, flap_velocity);
+            }
+        }
+    }
+}
+
+void Flock::Integrate(float gravity, float death_acceleration) {
+    float *y = y_.data();
+    float *velocity = velocity_.data();
+    const uint8_t *started = started_.data();
+    const uint8_t *crashed = crashed_.data();
+    const uint8_t *landed = landed_.data();
+    // written as selects rather than branches so the compiler can vectorize it
+    for (size_t i = 0; i < y_.size(); i++) {
+        bool moving = started[i] && !landed[i];
+        float new_velocity = velocity[i] + (crashed[i] ? death_acceleration : gravity);
+        velocity[i] = moving ? new_velocity : velocity[i];
+        y[i] = moving ? y[i] + new_velocity : y[i];
+    }
+}
+
+void Flock::Collide(const FlockSpan *spans, size_t num_spans) {
+    const float *y = y_.data();
+    uint8_t *hits = hits_.data();
+    size_t count = y_.size();
+    std::fill(hits_.begin(), hits_.end(), 0);
+    // spans on the outside so the inner loop is the same compare for every bird
+    for (size_t s = 0; s < num_spans; s++) {
+        const FlockSpan span = spans[s];
+        for (size_t i = 0; i < count; i++) {
+            float probe = y[i] + span.offset_;
+            hits[i] |= probe >= span.low_ && probe <= span.high_;
+        }
+    }
+    crashed_this_tick_.clear();
+    for (size_t i = 0; i < count; i++) {
+        if (hits[i] && !crashed_[i] && !landed_[i]) {
+            crashed_[i] = 1;
+            num_alive_--;
+            if (started_[i]) {
+                num_flying_--;
+            }
+            // a bird that is hit before its first flap falls too
+            started_[i] = 1;
+            crashed_this_tick_.push_back(i);
+        }
+    }
+}
+
+void Flock::Land(float ground_y) {
+    for (size_t i = 0; i < y_.size(); i++) {
+        if (!landed_[i] && y_[i] >= ground_y) {
+            landed_[i] = 1;
+            velocity_[i] = 0;
+            num_landed_++;
+            if (!crashed_[i]) {
+                num_alive_--;
+                num_flying_--;
+            }
+        }
+    }
+}
+
+void Flock::AwardPoint() {
+    uint32_t *scores = scores_.data();
+    const uint8_t *crashed = crashed_.data();
+    const uint8_t *landed = landed_.data();
+    for (size_t i = 0; i < scores_.size(); i++) {
+        scores[i] += !crashed[i] && !landed[i];
+    }
+}
+
+size_t Flock::GetCount() const {
+    return y_.size();
+}
+
+size_t Flock::GetAliveCount() const {
+    return num_alive_;
+}
+
+size_t Flock::GetFlyingCount() const {
+    return num_flying_;
+}
+
+size_t Flock::GetLandedCount() const {
+    return num_landed_;
+}
+
+uint32_t Flock::GetBestScore() const {
+    return scores_.empty() ? 0 : *std::max_element(scores_.begin(), scores_.end());
+}
+
+const float *Flock::GetY() const {
+    return y_.data();
+}
+
+const float *Flock::GetVelocity() const {
+    return velocity_.data();
+}
+
+const uint32_t *Flock::GetScores() const {
+    return scores_.data();
+}
+
+const uint32_t *Flock::GetColors() const {
+    return colors_.data();
+}
+
+int Flock::GetKeyCode(size_t index) const {
+    return key_codes_[index];
+}
+
+bool Flock::IsAlive(size_t index) const {
+    return !crashed_[index] && !landed_[index];
+}
+
+const std::vector<size_t> &Flock::GetCrashedThisTick() const {
+    return crashed_this_tick_;
+}
+} // namespace flappybird
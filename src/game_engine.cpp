@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
 #include <string>
 #include <utility>
 #include <game_engine.h>
@@ -5,16 +9,13 @@
 namespace flappybird {
     
 using std::string;
-using std::greater;
 using std::vector;
 using std::to_string;
-using std::sort;
 using std::move;
 using ci::Color;
 using ci::Font;
 using ci::Rectf;
 using ci::gl::color;
-using ci::gl::drawStringCentered;
 using ci::gl::drawSolidRect;
 using ci::gl::drawSolidCircle;
 using ci::gl::drawStrokedCircle;
@@ -29,111 +30,511 @@ GameEngine::GameEngine() {
     customize_yellow_.highlighted_ = true;
     customize_green_.highlighted_ = true;
     start_normal_.highlighted_ = true;
+    // reserving up front means spawning and removing obstacles never reallocates during play
+    obstacles_.reserve(std::max<size_t>(kNumObstaclesOnScreen + 1, kMaxCourseObstacles));
+    storm_obstacles_.reserve(kStormObstacleCount);
+    run_flap_frames_.reserve(kReservedRunFlaps);
+    score_text_.reserve(kScoreTextCapacity);
+    final_score_text_.reserve(kFinalScoreMessage.size() + kScoreTextCapacity);
+    UpdateScoreText(0);
 }
 
+void GameEngine::LoadFonts(const AssetPack *pack) {
+    title_font_.Load(kGameFont, kTitleFontSize, pack);
+    instruction_font_.Load(kGameFont, kInstructionFontSize, pack);
+    option_font_.Load(kGameFont, kOptionFontSize, pack);
+    score_font_.Load(kGameFont, kScoreFontSize, pack);
+    game_over_title_font_.Load(kGameFont, kGameOverTitleFontSize, pack);
+    final_score_font_.Load(kGameFont, kFinalScoreMessageFontSize, pack);
+    for (Button *button : {&start_leaderboard_, &start_customize_, &start_challenge_, &start_normal_, &start_storm_,
+                           &start_course_, &gameover_restart_, &gameover_leaderboard_, &back_, &customize_red_,
+                           &customize_yellow_, &customize_blue_, &customize_purple_, &customize_orange_,
+                           &customize_green_}) {
+        button->LoadFont(pack);
+    }
+    leaderboard_.LoadFonts(pack);
+    fonts_loaded_ = true;
+}
+
+const string &GameEngine::GetFontName() const {
+    return kGameFont;
+}
+
+vector<float> GameEngine::GetFontSizes() const {
+    vector<float> sizes = {kTitleFontSize, kInstructionFontSize, kOptionFontSize, kScoreFontSize,
+                           kGameOverTitleFontSize, kFinalScoreMessageFontSize, leaderboard_.kLeaderboardTitleFontSize,
+                           leaderboard_.kScoreFontSize};
+    for (const Button *button : {&start_leaderboard_, &start_customize_, &start_challenge_, &start_normal_,
+                                 &start_storm_, &start_course_, &gameover_restart_, &gameover_leaderboard_, &back_,
+                                 &customize_red_, &customize_yellow_, &customize_blue_, &customize_purple_,
+                                 &customize_orange_, &customize_green_}) {
+        sizes.push_back(button->font_size_);
+    }
+    std::sort(sizes.begin(), sizes.end());
+    sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+    return sizes;
+}
+
+const size_t GameEngine::kSnapshotLeaderboardSize;
+const size_t GameEngine::kScoreTextCapacity;
+const size_t GameEngine::kMaxParticles;
+
 void GameEngine::Display() {
-    DisplayStartScreen();
-    DisplayCustomizeScreen();
-    DisplayLeaderboard();
-    DisplayGameScreen();
-    DisplayGameOverScreen();
+    if (!fonts_loaded_) {
+        LoadFonts();
+    }
+    WriteSnapshot(display_snapshot_);
+    Display(display_snapshot_);
 }
 
-void GameEngine::DisplayStartScreen() {
-    if (current_game_state_ == StartScreen) {
-        Font title_font = Font(kGameFont, kTitleFontSize);
-        drawStringCentered(kGameTitle, vec2(kTitleX_Position, kTitleY_Position), kGameTextColor, title_font);
-        Font instruction_font = Font(kGameFont, kInstructionFontSize);
-        drawStringCentered(kInstruction, vec2(kInstructionX_Position, kInstructionY_Position), kGameTextColor
-                           , instruction_font);
-        bird_.Display();
+void GameEngine::Display(const Snapshot &snapshot) const {
+    DisplayStartScreen(snapshot);
+    DisplayCustomizeScreen(snapshot);
+    DisplayLeaderboard(snapshot);
+    DisplayGameScreen(snapshot);
+    DisplayGameOverScreen(snapshot);
+}
+
+void GameEngine::WriteSnapshot(Snapshot &snapshot) const {
+    snapshot.game_state_ = current_game_state_;
+    snapshot.bird_ = bird_;
+    if (game_mode_ == PipeStorm) {
+        // only the storm obstacles inside the window are copied, so drawing cost follows what is on screen
+        size_t first;
+        size_t last;
+        FindStormObstacles(0, kWindowSize, first, last);
+        if (snapshot.obstacles_.size() < last - first) {
+            snapshot.obstacles_.resize(last - first);
+        }
+        snapshot.num_obstacles_ = 0;
+        for (size_t i = first; i < last; i++) {
+            const StormObstacle &storm_obstacle = storm_obstacles_[i];
+            float left = storm_obstacle.x_;
+            float right = storm_obstacle.GetRight();
+            // the broadphase range can still hold narrow pipes that already left the window behind wider ones
+            if (right < 0) {
+                continue;
+            }
+            float gap_top = storm_obstacle.GetGapTop();
+            float gap_bottom = storm_obstacle.GetGapBottom();
+            Obstacle &obstacle = snapshot.obstacles_[snapshot.num_obstacles_++];
+            obstacle.upper_main_.set(left, 0, right, gap_top);
+            obstacle.lower_main_.set(left, gap_bottom, right, kWindowSize - kGroundHeight);
+            obstacle.upper_secondary_.set(left - kStormLipWidth, gap_top - kStormLipHeight, right + kStormLipWidth,
+                                          gap_top);
+            obstacle.lower_secondary_.set(left - kStormLipWidth, gap_bottom, right + kStormLipWidth, 
+                                          gap_bottom + kStormLipHeight);
+            obstacle.color_ = kObstacleColor;
+        }
+    } else {
+        if (snapshot.obstacles_.size() < obstacles_.size()) {
+            snapshot.obstacles_.resize(obstacles_.size());
+        }
+        snapshot.num_obstacles_ = obstacles_.size();
+        for (size_t i = 0; i < snapshot.num_obstacles_; i++) {
+            snapshot.obstacles_[i] = obstacles_[i];
+        }
+    }
+    snapshot.score_ = score_;
+    snapshot.flock_y_.assign(flock_.GetY(), flock_.GetY() + flock_.GetCount());
+    snapshot.flock_colors_.assign(flock_.GetColors(), flock_.GetColors() + flock_.GetCount());
+    snapshot.num_particles_ = particles_.GetCount();
+    std::copy(particles_.GetX(), particles_.GetX() + snapshot.num_particles_, snapshot.particle_x_);
+    std::copy(particles_.GetY(), particles_.GetY() + snapshot.num_particles_, snapshot.particle_y_);
+    std::copy(particles_.GetLife(), particles_.GetLife() + snapshot.num_particles_, snapshot.particle_life_);
+    std::copy(particles_.GetKinds(), particles_.GetKinds() + snapshot.num_particles_, snapshot.particle_kinds_);
+    for (size_t i = 0; i < kSnapshotLeaderboardSize; i++) {
+        snapshot.leaderboard_scores_[i] = leaderboard_.scores_[i];
+    }
+    snapshot.normal_highlighted_ = start_normal_.highlighted_;
+    snapshot.challenge_highlighted_ = start_challenge_.highlighted_;
+    snapshot.storm_highlighted_ = start_storm_.highlighted_;
+    snapshot.course_loaded_ = course_.IsOpen();
+    snapshot.course_highlighted_ = start_course_.highlighted_;
+    snapshot.red_highlighted_ = customize_red_.highlighted_;
+    snapshot.yellow_highlighted_ = customize_yellow_.highlighted_;
+    snapshot.blue_highlighted_ = customize_blue_.highlighted_;
+    snapshot.purple_highlighted_ = customize_purple_.highlighted_;
+    snapshot.orange_highlighted_ = customize_orange_.highlighted_;
+    snapshot.green_highlighted_ = customize_green_.highlighted_;
+}
+
+void GameEngine::WriteSpectatorState(SpectatorState &state) const {
+    state.game_state_ = current_game_state_;
+    state.score_ = score_;
+    state.bird_x_ = bird_.position_.x;
+    state.bird_y_ = bird_.position_.y;
+    state.bird_velocity_ = bird_.y_velocity_;
+    if (IsFlockRun()) {
+        // spectators follow the first bird of the flock, which is player one when anyone plays from the keyboard
+        state.bird_y_ = flock_.GetY()[0];
+        state.bird_velocity_ = flock_.GetVelocity()[0];
+    }
+    state.num_obstacles_ = 0;
+    if (game_mode_ == PipeStorm) {
+        // spectators get the storm pipes from the bird onwards
+        size_t first;
+        size_t last;
+        FindStormObstacles(bird_.position_.x - bird_.radius_, kWindowSize, first, last);
+        for (size_t i = first; i < last && state.num_obstacles_ < SpectatorState::kMaxObstacles; i++) {
+            SpectatorState::Gap &gap = state.obstacles_[state.num_obstacles_++];
+            gap.x_ = storm_obstacles_[i].x_;
+            gap.gap_top_ = storm_obstacles_[i].GetGapTop();
+            gap.gap_bottom_ = storm_obstacles_[i].GetGapBottom();
+        }
+        return;
+    }
+    for (const Obstacle &obstacle : obstacles_) {
+        if (state.num_obstacles_ == SpectatorState::kMaxObstacles) {
+            break;
+        }
+        SpectatorState::Gap &gap = state.obstacles_[state.num_obstacles_++];
+        gap.x_ = obstacle.upper_main_.getX1();
+        gap.gap_top_ = obstacle.upper_main_.getY2();
+        gap.gap_bottom_ = obstacle.lower_main_.getY1();
+    }
+}
+
+void GameEngine::WriteSessionStats(SessionStats &stats) const {
+    stats.game_state_ = current_game_state_;
+    stats.game_mode_ = game_mode_;
+    stats.score_ = score_;
+    stats.obstacle_count_ = game_mode_ == PipeStorm ? storm_obstacles_.size() : obstacles_.size();
+}
+
+void GameEngine::DisplayStartScreen(const Snapshot &snapshot) const {
+    if (snapshot.game_state_ == StartScreen) {
+        title_font_.DrawCentered(kGameTitle, vec2(kTitleX_Position, kTitleY_Position), kGameTextColor);
+        instruction_font_.DrawCentered(kInstruction, vec2(kInstructionX_Position, kInstructionY_Position),
+                                       kGameTextColor);
+        snapshot.bird_.Display();
         ground_.Display();
-        start_customize_.Display();
-        start_leaderboard_.Display();
-        start_challenge_.Display();
-        start_normal_.Display();
+        start_customize_.Display(false);
+        start_leaderboard_.Display(false);
+        start_challenge_.Display(snapshot.challenge_highlighted_);
+        start_normal_.Display(snapshot.normal_highlighted_);
+        start_storm_.Display(snapshot.storm_highlighted_);
+        // there is only a course to pick once one was loaded
+        if (snapshot.course_loaded_) {
+            start_course_.Display(snapshot.course_highlighted_);
+        }
     }
 }
 
-void GameEngine::DisplayCustomizeScreen() {
-    if (current_game_state_ == CustomizeScreen) {
-        back_.Display();
-        Font option_font = Font(kGameFont, kOptionFontSize);
-        drawStringCentered(kOption_1, vec2(kOption_1_X_Position, kOption_1_Y_Position), kGameTextColor, 
-                           option_font);
-        customize_red_.Display();
-        customize_yellow_.Display();
-        customize_blue_.Display();
-        drawStringCentered(kOption_2, vec2(kOption_2_X_Position, kOption_2_Y_Position), kGameTextColor, 
-                           option_font);
-        customize_purple_.Display();
-        customize_orange_.Display();
-        customize_green_.Display();
-    }
-}
-
-void GameEngine::DisplayLeaderboard() {
-    if (current_game_state_ == LeaderBoard) {
-        color(Color(kLeaderboardBackground));
+void GameEngine::DisplayCustomizeScreen(const Snapshot &snapshot) const {
+    if (snapshot.game_state_ == CustomizeScreen) {
+        back_.Display(false);
+        option_font_.DrawCentered(kOption_1, vec2(kOption_1_X_Position, kOption_1_Y_Position), kGameTextColor);
+        customize_red_.Display(snapshot.red_highlighted_);
+        customize_yellow_.Display(snapshot.yellow_highlighted_);
+        customize_blue_.Display(snapshot.blue_highlighted_);
+        option_font_.DrawCentered(kOption_2, vec2(kOption_2_X_Position, kOption_2_Y_Position), kGameTextColor);
+        customize_purple_.Display(snapshot.purple_highlighted_);
+        customize_orange_.Display(snapshot.orange_highlighted_);
+        customize_green_.Display(snapshot.green_highlighted_);
+    }
+}
+
+void GameEngine::DisplayLeaderboard(const Snapshot &snapshot) const {
+    if (snapshot.game_state_ == LeaderBoard) {
+        color(kLeaderboardBackground);
         drawSolidRect(Rectf(vec2(0, 0), vec2(kWindowSize, kWindowSize)));
-        leaderboard_.Display();
-        back_.Display();
+        leaderboard_.Display(snapshot.leaderboard_scores_);
+        back_.Display(false);
     }
 }
 
-void GameEngine::DisplayGameScreen() {
-    if (current_game_state_ == GameScreen) {
-        for (const Obstacle& obstacle: obstacles_) {
-            obstacle.Display();
+void GameEngine::DisplayGameScreen(const Snapshot &snapshot) const {
+    if (snapshot.game_state_ == GameScreen) {
+        for (size_t i = 0; i < snapshot.num_obstacles_; i++) {
+            snapshot.obstacles_[i].Display();
+        }
+        if (!snapshot.flock_y_.empty()) {
+            DisplayFlock(snapshot);
+        } else {
+            snapshot.bird_.Display();
         }
-        bird_.Display();
         ground_.Display();
-        Font score_font = Font(kGameFont, kScoreFontSize);
-        drawStringCentered(to_string(score_), vec2(kScore_X_Position, kScore_Y_Position), kGameTextColor, 
-                           score_font);
+        DisplayParticles(snapshot);
+        UpdateScoreText(snapshot.score_);
+        score_font_.DrawCentered(score_text_, vec2(kScore_X_Position, kScore_Y_Position), kGameTextColor);
     }
 }
 
-void GameEngine::DisplayGameOverScreen() {
-    if (current_game_state_ == GameOverScreen) {
-        color(Color(kGameOverBackground));
+void GameEngine::DisplayGameOverScreen(const Snapshot &snapshot) const {
+    if (snapshot.game_state_ == GameOverScreen) {
+        color(kGameOverBackground);
         drawSolidRect(Rectf(vec2(0, 0), vec2(kWindowSize, kWindowSize)));
-        Font TitleFont = Font(kGameFont, kGameOverTitleFontSize);
-        drawStringCentered(kGameOverTitle, vec2(kGameOverTitle_X_Position, kGameOverTitle_Y_Position), 
-                           kGameTextColor, TitleFont);
-        Font kScoreFont = Font(kGameFont, kFinalScoreMessageFontSize);
-        drawStringCentered(kFinalScoreMessage + to_string(score_), vec2(kFinalScoreMessage_X_Position, 
-                                                                        kFinalScoreMessage_Y_Position),
-                           kGameTextColor, kScoreFont);
-        gameover_restart_.Display();
-        gameover_leaderboard_.Display();
+        game_over_title_font_.DrawCentered(kGameOverTitle, vec2(kGameOverTitle_X_Position, kGameOverTitle_Y_Position),
+                                           kGameTextColor);
+        UpdateScoreText(snapshot.score_);
+        final_score_font_.DrawCentered(final_score_text_,
+                                       vec2(kFinalScoreMessage_X_Position, kFinalScoreMessage_Y_Position),
+                                       kGameTextColor);
+        gameover_restart_.Display(false);
+        gameover_leaderboard_.Display(false);
     }
 }
  
+void GameEngine::DisplayParticles(const Snapshot &snapshot) const {
+    if (snapshot.num_particles_ == 0) {
+        return;
+    }
+    if (!particle_batch_) {
+        particle_batch_ = ci::gl::VertBatch::create(GL_TRIANGLES);
+    }
+    // every particle becomes a small quad in one vertex batch so the whole effect layer is a single draw call
+    particle_batch_->clear();
+    for (size_t i = 0; i < snapshot.num_particles_; i++) {
+        float size = kFeatherSize;
+        Color particle_color = kFeatherColor;
+        if (snapshot.particle_kinds_[i] == ParticleSystem::Spark) {
+            size = kSparkSize;
+            particle_color = kSparkColor;
+        } else if (snapshot.particle_kinds_[i] == ParticleSystem::Debris) {
+            size = kDebrisSize;
+            particle_color = kDebrisColor;
+        }
+        float alpha = snapshot.particle_life_[i] < kParticleFadeTicks ? snapshot.particle_life_[i] / kParticleFadeTicks 
+                                                                       : 1;
+        particle_batch_->color(ci::ColorA(particle_color, alpha));
+        float x = snapshot.particle_x_[i];
+        float y = snapshot.particle_y_[i];
+        particle_batch_->vertex(vec2(x - size, y - size));
+        particle_batch_->vertex(vec2(x + size, y - size));
+        particle_batch_->vertex(vec2(x + size, y + size));
+        particle_batch_->vertex(vec2(x - size, y - size));
+        particle_batch_->vertex(vec2(x + size, y + size));
+        particle_batch_->vertex(vec2(x - size, y + size));
+    }
+    particle_batch_->draw();
+}
+
+void GameEngine::DisplayFlock(const Snapshot &snapshot) const {
+    if (!flock_batch_) {
+        flock_batch_ = ci::gl::VertBatch::create(GL_TRIANGLES);
+    }
+    if (flock_bird_rim_.empty()) {
+        for (size_t segment = 0; segment <= kFlockBirdSegments; segment++) {
+            float angle = kTwoPi * segment / kFlockBirdSegments;
+            flock_bird_rim_.push_back(vec2(kRadius * cosf(angle), kRadius * sinf(angle)));
+        }
+    }
+    // every bird is a small polygon in one vertex batch, drawn back to front so the first birds, the players, end
+    // up on top
+    flock_batch_->clear();
+    float x = kX_Position;
+    for (size_t i = snapshot.flock_y_.size(); i-- > 0;) {
+        uint32_t packed = snapshot.flock_colors_[i];
+        flock_batch_->color(ci::ColorA(((packed >> 16) & 0xff) / 255.0f, ((packed >> 8) & 0xff) / 255.0f, 
+                                       (packed & 0xff) / 255.0f, (packed >> 24) / 255.0f));
+        vec2 center(x, snapshot.flock_y_[i]);
+        for (size_t segment = 0; segment < kFlockBirdSegments; segment++) {
+            flock_batch_->vertex(center);
+            flock_batch_->vertex(center + flock_bird_rim_[segment]);
+            flock_batch_->vertex(center + flock_bird_rim_[segment + 1]);
+        }
+    }
+    flock_batch_->draw();
+}
+
+void GameEngine::UpdateScoreText(size_t score) const {
+    if (score == displayed_score_ && !score_text_.empty()) {
+        return;
+    }
+    char digits[kScoreTextCapacity];
+    snprintf(digits, sizeof(digits), "%zu", score);
+    score_text_.assign(digits);
+    final_score_text_.assign(kFinalScoreMessage);
+    final_score_text_.append(digits);
+    displayed_score_ = score;
+}
+
 void GameEngine::AdvanceOneFrame() {
-    if (current_game_state_ == GameScreen) {
+    if (current_game_state_ == GameScreen && IsFlockRun()) {
+        // controllers decide before the tick, like key presses arriving between ticks
+        BirdObservation observation;
+        FindNextGap(observation);
+        flock_.RunControllers(observation, flap_velocity_);
+    }
+    if (current_game_state_ == GameScreen && game_mode_ == PipeStorm) {
+        UpdateStormObstacles();
+        AdvanceBirds();
+        particles_.Update(kParticleGravity, kStormTickScale);
+    } else if (current_game_state_ == GameScreen && game_mode_ == Course) {
+        UpdateObstacles();
+        UpdateCourseObstacles();
+        AdvanceBirds();
+        particles_.Update(kParticleGravity, 1);
+    } else if (current_game_state_ == GameScreen) {
         UpdateObstacles();
         UpdateObstacleVector();
         UpdateScore();
+        AdvanceBirds();
+        particles_.Update(kParticleGravity, 1);
+    }
+    run_frame_++;
+}
+
+void GameEngine::AdvanceBirds() {
+    if (IsFlockRun()) {
+        AdvanceFlock();
+    } else if (game_mode_ == PipeStorm) {
+        bird_.UpdateBird();
+        HandleStormCollision();
+    } else {
         bird_.UpdateBird();
         HandleCollision();
     }
 }
 
+bool GameEngine::IsFlockRun() const {
+    return flock_.GetCount() > 0;
+}
+
+bool GameEngine::HasDied() const {
+    return current_game_state_ == GameOverScreen && !course_finished_ && course_error_.empty();
+}
+
+bool GameEngine::IsScrolling() const {
+    return IsFlockRun() ? flock_.GetFlyingCount() > 0 : !has_collided_ && bird_.started_;
+}
+
+void GameEngine::AwardPoint() {
+    if (IsFlockRun()) {
+        flock_.AwardPoint();
+        score_ = flock_.GetBestScore();
+        return;
+    }
+    score_++;
+    particles_.Emit(ParticleSystem::Spark, bird_.position_.x, bird_.position_.y, kSparkCount, kSparkSpeed, 
+                    kSparkLifetime);
+}
+
+void GameEngine::AdvanceFlock() {
+    flock_.Integrate(bird_.gravity_, bird_death_acceleration_);
+    FindFlockSpans();
+    flock_.Collide(flock_spans_.data(), flock_spans_.size());
+    // only players get a crash effect, a wall of bots hitting the same pipe would drown the screen
+    for (size_t i : flock_.GetCrashedThisTick()) {
+        if (flock_.GetKeyCode(i) != Flock::kNoKey) {
+            particles_.Emit(ParticleSystem::Debris, kX_Position, flock_.GetY()[i], kDebrisCount, kDebrisSpeed, 
+                            kDebrisLifetime);
+        }
+    }
+    flock_.Land(kWindowSize - kBottomHeight - kTopHeight - kRadius);
+    if (flock_.GetLandedCount() == flock_.GetCount()) {
+        leaderboard_.ManageScores(score_);
+        current_game_state_ = GameOverScreen;
+    }
+}
+
+void GameEngine::FindFlockSpans() {
+    const float infinity = std::numeric_limits<float>::infinity();
+    float x = kX_Position;
+    float radius = kRadius;
+    flock_spans_.clear();
+    // the same floor and ceiling HandleCollision uses
+    flock_spans_.push_back({0, kWindowSize - radius, infinity});
+    flock_spans_.push_back({0, -infinity, radius});
+    if (game_mode_ == PipeStorm) {
+        size_t first;
+        size_t last;
+        FindStormObstacles(x - radius, x + radius, first, last);
+        for (size_t i = first; i < last; i++) {
+            const StormObstacle &obstacle = storm_obstacles_[i];
+            if (obstacle.GetRight() >= x - radius) {
+                // the storm test is strict, nextafter turns it into the closed span exactly
+                flock_spans_.push_back({-radius, -infinity, std::nextafter(obstacle.GetGapTop(), -infinity)});
+                flock_spans_.push_back({radius, std::nextafter(obstacle.GetGapBottom(), infinity), infinity});
+            }
+        }
+        return;
+    }
+    // HandleCollision tests the bird's right corners against the rectangles, every rectangle that covers the
+    // corners' x gives the heights the corner can't be at
+    float corner_x = x + radius;
+    for (const Obstacle &obstacle : obstacles_) {
+        for (const Rectf *rect : {&obstacle.upper_main_, &obstacle.upper_secondary_}) {
+            if (corner_x >= rect->getX1() && corner_x <= rect->getX2()) {
+                flock_spans_.push_back({-radius, rect->getY1(), rect->getY2()});
+            }
+        }
+        for (const Rectf *rect : {&obstacle.lower_main_, &obstacle.lower_secondary_}) {
+            if (corner_x >= rect->getX1() && corner_x <= rect->getX2()) {
+                flock_spans_.push_back({radius, rect->getY1(), rect->getY2()});
+            }
+        }
+    }
+}
+
+void GameEngine::FindNextGap(BirdObservation &observation) const {
+    float x = kX_Position;
+    observation.has_gap_ = false;
+    observation.gap_top_ = 0;
+    observation.gap_bottom_ = kWindowSize - kGroundHeight;
+    observation.gap_distance_ = 0;
+    if (game_mode_ == PipeStorm) {
+        size_t first;
+        size_t last;
+        // several storm pipes overlap the bird at once, what it has to fly through is what all of them leave open
+        FindStormObstacles(x - kRadius, x + kRadius + kStormLookAhead, first, last);
+        for (size_t i = first; i < last; i++) {
+            const StormObstacle &obstacle = storm_obstacles_[i];
+            if (obstacle.GetRight() < x - kRadius) {
+                continue;
+            }
+            if (!observation.has_gap_) {
+                observation.has_gap_ = true;
+                observation.gap_distance_ = obstacle.x_ - x;
+            }
+            observation.gap_top_ = std::max(observation.gap_top_, obstacle.GetGapTop());
+            observation.gap_bottom_ = std::min(observation.gap_bottom_, obstacle.GetGapBottom());
+        }
+        return;
+    }
+    // only pipes that are already on screen count, controllers see what a player sees
+    for (const Obstacle &obstacle : obstacles_) {
+        if (obstacle.upper_main_.getX2() >= x - kRadius && obstacle.upper_main_.getX1() <= kWindowSize) {
+            observation.has_gap_ = true;
+            observation.gap_top_ = obstacle.upper_main_.getY2();
+            observation.gap_bottom_ = obstacle.lower_main_.getY1();
+            observation.gap_distance_ = obstacle.upper_main_.getX1() - x;
+            return;
+        }
+    }
+}
+
+size_t GameEngine::AddFlockBird(int key_code, std::shared_ptr<BirdController> controller, const Color &bird_color) {
+    float alpha = controller ? kGhostAlpha : 1;
+    uint32_t packed = static_cast<uint32_t>(alpha * 255) << 24 | static_cast<uint32_t>(bird_color.r * 255) << 16 |
+                      static_cast<uint32_t>(bird_color.g * 255) << 8 | static_cast<uint32_t>(bird_color.b * 255);
+    return flock_.AddBird(key_code, std::move(controller), packed, kInitialY_Position);
+}
+
+void GameEngine::ClearFlock() {
+    flock_.Clear();
+}
+
+const Flock &GameEngine::GetFlock() const {
+    return flock_;
+}
+
 void GameEngine::UpdateObstacles() {
-    // Shifts obstacles to the left
-    if (!has_collided_ && bird_.started_) {
+    // Shifts obstacles to the left, each one at the speed it was spawned with
+    if (IsScrolling()) {
         for (Obstacle &obstacle : obstacles_) {
-            obstacle.upper_main_.set(obstacle.upper_main_.getX1() - ObstacleSpeed, obstacle.upper_main_.getY1(), 
-                                     obstacle.upper_main_.getX2() - ObstacleSpeed, obstacle.upper_main_.getY2());
-            obstacle.lower_main_.set(obstacle.lower_main_.getX1() - ObstacleSpeed, obstacle.lower_main_.getY1(), 
-                                     obstacle.lower_main_.getX2() - ObstacleSpeed, obstacle.lower_main_.getY2());
-            obstacle.upper_secondary_.set(obstacle.upper_secondary_.getX1() - ObstacleSpeed, 
+            float speed = obstacle.speed_;
+            obstacle.upper_main_.set(obstacle.upper_main_.getX1() - speed, obstacle.upper_main_.getY1(), 
+                                     obstacle.upper_main_.getX2() - speed, obstacle.upper_main_.getY2());
+            obstacle.lower_main_.set(obstacle.lower_main_.getX1() - speed, obstacle.lower_main_.getY1(), 
+                                     obstacle.lower_main_.getX2() - speed, obstacle.lower_main_.getY2());
+            obstacle.upper_secondary_.set(obstacle.upper_secondary_.getX1() - speed, 
                                           obstacle.upper_secondary_.getY1(), obstacle.upper_secondary_.getX2() - 
-                                          ObstacleSpeed, obstacle.upper_secondary_.getY2());
-            obstacle.lower_secondary_.set(obstacle.lower_secondary_.getX1() - ObstacleSpeed, 
+                                          speed, obstacle.upper_secondary_.getY2());
+            obstacle.lower_secondary_.set(obstacle.lower_secondary_.getX1() - speed, 
                                           obstacle.lower_secondary_.getY1(), obstacle.lower_secondary_.getX2() - 
-                                          ObstacleSpeed, obstacle.lower_secondary_.getY2());
+                                          speed, obstacle.lower_secondary_.getY2());
         }
     }
 }
@@ -142,7 +543,10 @@ void GameEngine::UpdateObstacleVector() {
     // Removes and adds obstacles as the game progresses
     if (obstacles_.empty()) {
         for (size_t i = 0; i < kNumObstaclesOnScreen; i++) {
-            float lower_bound = rand() % kObstacleRange + ((kWindowSize - kGroundHeight) / kLowerBoundDivider);
+            float lower_bound = PickGapBottom(i == 0 ? nullptr : &GetReachability(),
+                                              i == 0 ? 0 : obstacles_.back().lower_main_.getY1(),
+                                              (kWindowSize - kGroundHeight) / kLowerBoundDivider, kObstacleRange,
+                                              random_engine_);
             float upper_bound = lower_bound - kGapSize;
             Obstacle obstacle(Rectf(vec2(((kWindowSize / kNumObstaclesOnScreen) * i) + 
             kStartingIncrement, 0),vec2((((kWindowSize / kNumObstaclesOnScreen) * i) + kStartingIncrement) 
@@ -159,11 +563,13 @@ void GameEngine::UpdateObstacleVector() {
                                     vec2((((kWindowSize / kNumObstaclesOnScreen) * i) + kStartingIncrement) + 
                                     kObstacleWidth + kSecondaryPipeWidth, lower_bound + kSecondaryPipeHeight)),
                               kObstacleColor);
+            obstacle.speed_ = ObstacleSpeed;
             obstacles_.push_back(obstacle);
         }
     }
     if (obstacles_[0].upper_main_.getX1() == obstacles_[0].pipe_width_) {
-        float lower_bound = rand() % kObstacleRange + (kWindowSize / kLowerBoundDivider);
+        float lower_bound = PickGapBottom(&GetReachability(), obstacles_.back().lower_main_.getY1(),
+                                          kWindowSize / kLowerBoundDivider, kObstacleRange, random_engine_);
         float upper_bound = lower_bound - kGapSize;
         Obstacle obstacle(Rectf(vec2(kWindowSize + kObstacleDelay, 0),
                                 vec2(kWindowSize + kObstacleWidth + kObstacleDelay, upper_bound)),
@@ -177,6 +583,7 @@ void GameEngine::UpdateObstacleVector() {
                           Rectf(vec2(kWindowSize + kObstacleDelay - kSecondaryPipeWidth, 
                                      lower_bound),vec2(kWindowSize + kObstacleWidth + kObstacleDelay + 
                                      kSecondaryPipeWidth, lower_bound + kSecondaryPipeHeight)), kObstacleColor);
+        obstacle.speed_ = ObstacleSpeed;
         obstacles_.push_back(obstacle);
     }
     // this makes sure the obstacle is removed after it has moved of the screen for smooth graphics
@@ -188,108 +595,423 @@ void GameEngine::UpdateObstacleVector() {
 void GameEngine::UpdateScore() {
     // if the bird passes the pipe, the player scores a point
     if (bird_.position_.x == obstacles_[0].upper_main_.getX2()) {
-        score_++;
+        AwardPoint();
     }
 }
 
 void GameEngine::HandleCollision() {
-    if (bird_.position_.y >= kWindowSize - bird_.radius_ || bird_.position_.y <= bird_.radius_ || 
-    obstacles_[0].upper_main_.contains(bird_.position_ + vec2(bird_.radius_, -bird_.radius_)) || 
-    obstacles_[0].lower_main_.contains(bird_.position_ + vec2(bird_.radius_, bird_.radius_)) || 
-    obstacles_[0].upper_secondary_.contains(bird_.position_ + vec2(bird_.radius_, -bird_.radius_)) || 
-    obstacles_[0].lower_secondary_.contains(bird_.position_ + vec2(bird_.radius_, bird_.radius_))) {
+    bool collided = bird_.position_.y >= kWindowSize - bird_.radius_ || bird_.position_.y <= bird_.radius_;
+    // normal pipes are far enough apart that only the first one can be near the bird, authored courses can pack
+    // several pipes around it so every pipe on screen is checked
+    for (const Obstacle &obstacle : obstacles_) {
+        collided = collided || obstacle.upper_main_.contains(bird_.position_ + vec2(bird_.radius_, -bird_.radius_)) ||
+                   obstacle.lower_main_.contains(bird_.position_ + vec2(bird_.radius_, bird_.radius_)) || 
+                   obstacle.upper_secondary_.contains(bird_.position_ + vec2(bird_.radius_, -bird_.radius_)) || 
+                   obstacle.lower_secondary_.contains(bird_.position_ + vec2(bird_.radius_, bird_.radius_));
+    }
+    if (collided) {
+        if (!has_collided_) {
+            particles_.Emit(ParticleSystem::Debris, bird_.position_.x, bird_.position_.y, kDebrisCount, 
+                            kDebrisSpeed, kDebrisLifetime);
+        }
         has_collided_ = true;
         bird_.has_collided_ = true;
-        bird_.acceleration_ = kBirdDeathAcceleration;
+        bird_.acceleration_ = bird_death_acceleration_;
     }
     HandleDeath();
 }
 
+float GameEngine::RandomBetween(float low, float high) {
+    return low + (high - low) * (static_cast<float>(random_engine_()) / random_engine_.max());
+}
+
+void GameEngine::UpdateStormObstacles() {
+    if (storm_obstacles_.empty()) {
+        storm_band_phase_ = 0;
+        storm_band_center_ = kStormBandCenter;
+        for (size_t i = 0; i < kStormObstacleCount; i++) {
+            StormObstacle obstacle;
+            RandomizeStormObstacle(obstacle);
+            obstacle.x_ = kStormStartingX + RandomBetween(0, kStormCourseLength);
+            storm_obstacles_.push_back(obstacle);
+        }
+        // the broadphase needs the storm sorted from the first frame on, not only once it starts moving
+        std::sort(storm_obstacles_.begin(), storm_obstacles_.end(),
+                  [](const StormObstacle &left, const StormObstacle &right) { return left.x_ < right.x_; });
+    }
+
+    // like the pipes of the other modes the storm waits for the first flap and stops once nobody is flying
+    if (!IsScrolling()) {
+        return;
+    }
+    storm_band_phase_ += kStormBandFrequency;
+    if (storm_band_phase_ > kTwoPi) {
+        storm_band_phase_ -= kTwoPi;
+    }
+    storm_band_center_ = kStormBandCenter + kStormBandAmplitude * sinf(storm_band_phase_);
+    float bird_x = bird_.position_.x;
+    for (StormObstacle &obstacle : storm_obstacles_) {
+        float old_right = obstacle.GetRight();
+        obstacle.x_ -= obstacle.speed_;
+        if (old_right >= bird_x && obstacle.GetRight() < bird_x) {
+            AwardPoint();
+        }
+        obstacle.phase_ += obstacle.frequency_;
+        obstacle.gap_center_ = storm_band_center_ + obstacle.amplitude_ * sinf(obstacle.phase_);
+        if (obstacle.GetRight() < 0) {
+            RandomizeStormObstacle(obstacle);
+            obstacle.x_ += kStormCourseLength;
+        }
+    }
+
+    // obstacles only overtake their neighbours a little each tick, so insertion sort is close to linear here
+    for (size_t i = 1; i < storm_obstacles_.size(); i++) {
+        StormObstacle obstacle = storm_obstacles_[i];
+        size_t j = i;
+        while (j > 0 && storm_obstacles_[j - 1].x_ > obstacle.x_) {
+            storm_obstacles_[j] = storm_obstacles_[j - 1];
+            j--;
+        }
+        storm_obstacles_[j] = obstacle;
+    }
+}
+
+void GameEngine::RandomizeStormObstacle(StormObstacle &obstacle) {
+    obstacle.width_ = RandomBetween(kStormMinWidth, kStormMaxWidth);
+    obstacle.speed_ = RandomBetween(kStormMinSpeed, kStormMaxSpeed);
+    obstacle.gap_size_ = RandomBetween(kStormMinGap, kStormMaxGap);
+    // the gap may wander off the band's center but never so far that the band sticks out of it
+    obstacle.amplitude_ = RandomBetween(0, (obstacle.gap_size_ - kStormBandHeight) / 2);
+    obstacle.phase_ = RandomBetween(0, kTwoPi);
+    obstacle.frequency_ = RandomBetween(kStormMinFrequency, kStormMaxFrequency);
+    obstacle.gap_center_ = storm_band_center_ + obstacle.amplitude_ * sinf(obstacle.phase_);
+}
+
+void GameEngine::FindStormObstacles(float left, float right, size_t &first, size_t &last) const {
+    // obstacles are sorted by their left edge and no wider than kStormMaxWidth, so anything starting before
+    // left - kStormMaxWidth can't reach left and anything starting after right can't overlap at all
+    auto starts_before = [](const StormObstacle &obstacle, float x) {
+        return obstacle.x_ < x;
+    };
+    auto starts_after = [](float x, const StormObstacle &obstacle) {
+        return x < obstacle.x_;
+    };
+    first = std::lower_bound(storm_obstacles_.begin(), storm_obstacles_.end(), left - kStormMaxWidth, 
+                             starts_before) - storm_obstacles_.begin();
+    last = std::upper_bound(storm_obstacles_.begin() + first, storm_obstacles_.end(), right, 
+                            starts_after) - storm_obstacles_.begin();
+    while (first < last && storm_obstacles_[first].GetRight() < left) {
+        first++;
+    }
+}
+
+void GameEngine::HandleStormCollision() {
+    vec2 position = bird_.position_;
+    float radius = bird_.radius_;
+    bool collided = position.y >= kWindowSize - radius || position.y <= radius;
+    size_t first;
+    size_t last;
+    FindStormObstacles(position.x - radius, position.x + radius, first, last);
+    for (size_t i = first; i < last && !collided; i++) {
+        const StormObstacle &obstacle = storm_obstacles_[i];
+        collided = obstacle.GetRight() >= position.x - radius && 
+                   (position.y - radius < obstacle.GetGapTop() || position.y + radius > obstacle.GetGapBottom());
+    }
+    if (collided) {
+        if (!has_collided_) {
+            particles_.Emit(ParticleSystem::Debris, position.x, position.y, kDebrisCount, kDebrisSpeed, 
+                            kDebrisLifetime);
+        }
+        has_collided_ = true;
+        bird_.has_collided_ = true;
+        bird_.acceleration_ = bird_death_acceleration_;
+    }
+    HandleDeath();
+}
+
+void GameEngine::UpdateCourseObstacles() {
+    float bird_x = bird_.position_.x;
+    if (IsScrolling()) {
+        // UpdateObstacles already moved the spawned pipes by their own speeds this tick, the next pipe's spacing
+        // is from the last spawned one so the spawn point moves along with that pipe
+        last_course_x_ -= ObstacleSpeed;
+        for (const Obstacle &obstacle : obstacles_) {
+            float right = obstacle.upper_main_.getX2();
+            if (right < bird_x && right + obstacle.speed_ >= bird_x) {
+                AwardPoint();
+            }
+        }
+    }
+    // a fast pipe can overtake a slow one, so pipes don't always leave the window in the order they came in
+    obstacles_.erase(std::remove_if(obstacles_.begin(), obstacles_.end(), [](const Obstacle &obstacle) {
+        return obstacle.upper_secondary_.getX2() < 0;
+    }), obstacles_.end());
+
+    size_t pipe_count = course_.GetPipeCount();
+    string pipe_error;
+    while (next_course_pipe_ < pipe_count && obstacles_.size() < kMaxCourseObstacles) {
+        // LoadCourse doesn't read the pipes, so each one is checked as it comes up, one broken pipe, say a NaN or
+        // non-positive speed or spacing, would otherwise stall the course
+        const CoursePipe &pipe = course_.GetPipe(next_course_pipe_);
+        if (!ValidateCoursePipe(pipe, pipe_error)) {
+            course_error_ = "pipe " + std::to_string(next_course_pipe_) + ": " + pipe_error;
+            current_game_state_ = GameOverScreen;
+            return;
+        }
+        float left = last_course_x_ + pipe.spacing_;
+        if (left > kWindowSize + kObstacleDelay) {
+            break;
+        }
+        float right = left + pipe.width_;
+        float lower_bound = pipe.gap_bottom_;
+        float upper_bound = pipe.gap_bottom_ - pipe.gap_size_;
+        Color pipe_color(((pipe.color_ >> 16) & 0xff) / 255.0f, ((pipe.color_ >> 8) & 0xff) / 255.0f, 
+                         (pipe.color_ & 0xff) / 255.0f);
+        obstacles_.push_back(Obstacle(Rectf(left, 0, right, upper_bound), 
+                                      Rectf(left, lower_bound, right, kWindowSize - kGroundHeight), 
+                                      Rectf(left - kSecondaryPipeWidth, upper_bound - kSecondaryPipeHeight, 
+                                            right + kSecondaryPipeWidth, upper_bound), 
+                                      Rectf(left - kSecondaryPipeWidth, lower_bound, right + kSecondaryPipeWidth, 
+                                            lower_bound + kSecondaryPipeHeight), pipe_color));
+        obstacles_.back().speed_ = pipe.speed_;
+        ObstacleSpeed = pipe.speed_;
+        last_course_x_ = left;
+        next_course_pipe_++;
+        course_.ReleaseBefore(next_course_pipe_);
+    }
+
+    // flying past the last pipe finishes the course
+    if (next_course_pipe_ == pipe_count && obstacles_.empty() && !has_collided_) {
+        course_finished_ = true;
+        leaderboard_.ManageScores(score_);
+        current_game_state_ = GameOverScreen;
+    }
+}
+
+void GameEngine::RestartCourse() {
+    course_.Rewind();
+    next_course_pipe_ = 0;
+    last_course_x_ = kWindowSize;
+    ObstacleSpeed = kNormalObstacleSpeed;
+}
+
+bool GameEngine::LoadCourse(const string &path, string &error) {
+    if (!course_.Open(path, error)) {
+        // the previous course is gone too, so a course run can't be started any more
+        if (game_mode_ == Course) {
+            SelectMode(Normal);
+        }
+        return false;
+    }
+    ResetGame();
+    SelectMode(Course);
+    return true;
+}
+
+const string &GameEngine::GetCourseError() const {
+    return course_error_;
+}
+
+void GameEngine::SelectMode(GameMode game_mode) {
+    game_mode_ = game_mode;
+    reachability_ = nullptr;
+    start_normal_.highlighted_ = game_mode == Normal;
+    start_challenge_.highlighted_ = game_mode == Challenge;
+    start_storm_.highlighted_ = game_mode == PipeStorm;
+    start_course_.highlighted_ = game_mode == Course;
+    flap_velocity_ = kFlapVelocity;
+    bird_death_acceleration_ = kBirdDeathAcceleration;
+    if (game_mode == Normal) {
+        ObstacleSpeed = kNormalObstacleSpeed;
+        bird_.gravity_ = kNormalGravity;
+    } else if (game_mode == Challenge) {
+        ObstacleSpeed = kChallengeObstacleSpeed;
+        bird_.gravity_ = kChallengeGravity;
+    } else if (game_mode == Course) {
+        RestartCourse();
+        bird_.gravity_ = kNormalGravity;
+    } else {
+        // a storm tick is a quarter of a normal tick, velocities scale with the tick and accelerations with its
+        // square so the bird flies exactly like in normal mode
+        flap_velocity_ = kFlapVelocity * kStormTickScale;
+        bird_death_acceleration_ = kBirdDeathAcceleration * kStormTickScale * kStormTickScale;
+        bird_.gravity_ = kNormalGravity * kStormTickScale * kStormTickScale;
+    }
+}
+
+FlightPhysics GameEngine::GetFlightPhysics(GameMode game_mode) const {
+    FlightPhysics physics;
+    physics.gravity_ = game_mode == Challenge ? kChallengeGravity : kNormalGravity;
+    physics.flap_velocity_ = kFlapVelocity;
+    physics.obstacle_speed_ = game_mode == Challenge ? kChallengeObstacleSpeed : kNormalObstacleSpeed;
+    physics.bird_radius_ = kRadius;
+    physics.obstacle_width_ = kObstacleWidth + 2 * kSecondaryPipeWidth;
+    // the first two pipes start this far apart, later ones alternate between it and one pipe_width_ more
+    physics.obstacle_spacing_ = kWindowSize / kNumObstaclesOnScreen;
+    physics.gap_size_ = kGapSize;
+    physics.ceiling_ = kRadius;
+    physics.ground_ = kWindowSize - kGroundHeight - kRadius;
+    // the first pipes are drawn from a range a little higher up than the rest
+    physics.min_gap_bottom_ = static_cast<int>((kWindowSize - kGroundHeight) / kLowerBoundDivider);
+    physics.max_gap_bottom_ = static_cast<int>(kWindowSize / kLowerBoundDivider + kObstacleRange) - 1;
+    return physics;
+}
+
+const ReachabilityTable &GameEngine::GetReachability() {
+    if (reachability_ == nullptr) {
+        reachability_ = &ReachabilityTable::Get(GetFlightPhysics(game_mode_));
+    }
+    return *reachability_;
+}
+
+void GameEngine::SetSeed(unsigned seed) {
+    random_engine_.seed(seed);
+}
+
+void GameEngine::StartRun(unsigned seed, GameMode game_mode) {
+    ResetGame();
+    SelectMode(game_mode);
+    BeginRun(seed);
+    current_game_state_ = GameScreen;
+}
+
+void GameEngine::BeginRun(unsigned seed) {
+    run_seed_ = seed;
+    SetSeed(seed);
+    run_frame_ = 0;
+    run_flap_frames_.clear();
+}
+
+unsigned GameEngine::GetRunSeed() const {
+    return run_seed_;
+}
+
+const vector<size_t> &GameEngine::GetRunFlapFrames() const {
+    return run_flap_frames_;
+}
+
+GameEngine::GameMode GameEngine::GetGameMode() const {
+    return game_mode_;
+}
+
+double GameEngine::GetTicksPerSecond() const {
+    return game_mode_ == PipeStorm ? kStormTicksPerSecond : kDefaultTicksPerSecond;
+}
+
 void GameEngine::HandleDeath() {
     if (bird_.position_.y >= kWindowSize - kBottomHeight -kTopHeight - bird_.radius_) {
         bird_.acceleration_ = 0;
         bird_.y_velocity_ = 0;
-        leaderboard_.scores_.push_back(score_);
-        leaderboard_.ManageScores();
+        leaderboard_.ManageScores(score_);
         current_game_state_ = GameOverScreen;
     }
 }
 
 void GameEngine::keyDown(const KeyEvent &event) {
-    if (event.getCode() == event.KEY_SPACE && current_game_state_ == StartScreen) {
+    HandleKeyPress(event.getCode());
+}
+
+void GameEngine::mouseDown(const MouseEvent &event) {
+    HandleClick(event.getPos());
+}
+
+void GameEngine::HandleInput(const InputEvent &input) {
+    if (input.type_ == InputEvent::KeyPress) {
+        HandleKeyPress(input.key_code_);
+    } else {
+        HandleClick(input.position_);
+    }
+}
+
+void GameEngine::HandleKeyPress(int key_code) {
+    if (key_code == KeyEvent::KEY_SPACE && current_game_state_ == StartScreen) {
         current_game_state_ = GameScreen;
+        BeginRun(seed_engine_());
+    }
+    if (key_code == KeyEvent::KEY_SPACE && current_game_state_ == GameScreen) {
+        // every press is logged, a replay feeds them all back and the ones the bird ignored stay ignored
+        run_flap_frames_.push_back(run_frame_);
     }
-    if (event.getCode() == event.KEY_SPACE && (!has_collided_) && current_game_state_ == GameScreen 
-        && bird_.y_velocity_ > kFlapBoundary) {
+    if (current_game_state_ == GameScreen && IsFlockRun()) {
+        for (size_t i = 0; i < flock_.GetCount(); i++) {
+            if (flock_.GetKeyCode(i) == key_code && flock_.Flap(i, flap_velocity_)) {
+                particles_.Emit(ParticleSystem::Feather, kX_Position, flock_.GetY()[i], kFeatherCount, 
+                                kFeatherSpeed, kFeatherLifetime);
+            }
+        }
+    } else if (key_code == KeyEvent::KEY_SPACE && (!has_collided_) && current_game_state_ == GameScreen 
+        && bird_.y_velocity_ > flap_velocity_ / 2) {
         bird_.started_ = true;
         bird_.acceleration_ = 0;
-        bird_.y_velocity_ = kFlapVelocity;
+        bird_.y_velocity_ = flap_velocity_;
+        particles_.Emit(ParticleSystem::Feather, bird_.position_.x, bird_.position_.y, kFeatherCount, 
+                        kFeatherSpeed, kFeatherLifetime);
     }
-    if (event.getCode() == event.KEY_SPACE && current_game_state_ == GameOverScreen) {
+    if (key_code == KeyEvent::KEY_SPACE && current_game_state_ == GameOverScreen) {
         ResetGame();
         current_game_state_ = StartScreen;
     }
 }
 
-void GameEngine::mouseDown(const MouseEvent &event) {
+void GameEngine::HandleClick(const vec2 &position) {
     if (current_game_state_ == StartScreen) {
-        if (start_normal_.area_.contains(event.getPos()) && start_challenge_.highlighted_) {
-            start_challenge_.highlighted_ = false;
-            start_normal_.highlighted_ = true;
-            ObstacleSpeed = kNormalObstacleSpeed;
-            bird_.gravity_ = kNormalGravity;
-        }
-        if (start_challenge_.area_.contains(event.getPos()) && start_normal_.highlighted_) {
-            start_normal_.highlighted_ = false;
-            start_challenge_.highlighted_ = true;
-            ObstacleSpeed = kChallengeObstacleSpeed;
-            bird_.gravity_ = kChallengeGravity;
-        }
-        if (start_leaderboard_.area_.contains(event.getPos())) {
+        if (start_normal_.area_.contains(position)) {
+            SelectMode(Normal);
+        }
+        if (start_challenge_.area_.contains(position)) {
+            SelectMode(Challenge);
+        }
+        if (start_storm_.area_.contains(position)) {
+            SelectMode(PipeStorm);
+        }
+        if (course_.IsOpen() && start_course_.area_.contains(position)) {
+            SelectMode(Course);
+        }
+        if (start_leaderboard_.area_.contains(position)) {
             current_game_state_ = LeaderBoard;
         }
-        if (start_customize_.area_.contains(event.getPos())) {
+        if (start_customize_.area_.contains(position)) {
             current_game_state_ = CustomizeScreen;
         }
     }
     if (current_game_state_ == CustomizeScreen) {
-        if (back_.area_.contains(event.getPos())) {
+        if (back_.area_.contains(position)) {
             ResetGame();
             current_game_state_ = StartScreen;
         }
 
-        if (customize_red_.area_.contains(event.getPos())) {
+        if (customize_red_.area_.contains(position)) {
             customize_red_.highlighted_ = true;
             customize_yellow_.highlighted_ = false;
             customize_blue_.highlighted_ = false;
             bird_.color_ = customize_red_.color_;
         }
-        if (customize_yellow_.area_.contains(event.getPos())) {
+        if (customize_yellow_.area_.contains(position)) {
             customize_red_.highlighted_ = false;
             customize_yellow_.highlighted_ = true;
             customize_blue_.highlighted_ = false;
             bird_.color_ = customize_yellow_.color_;
         }
-        if (customize_blue_.area_.contains(event.getPos())) {
+        if (customize_blue_.area_.contains(position)) {
             customize_red_.highlighted_ = false;
             customize_yellow_.highlighted_ = false;
             customize_blue_.highlighted_ = true;
             bird_.color_ = customize_blue_.color_;
         }
 
-        if (customize_purple_.area_.contains(event.getPos())) {
+        if (customize_purple_.area_.contains(position)) {
             customize_purple_.highlighted_ = true;
             customize_orange_.highlighted_ = false;
             customize_green_.highlighted_ = false;
             kObstacleColor = customize_purple_.color_;
         }
-        if (customize_orange_.area_.contains(event.getPos())) {
+        if (customize_orange_.area_.contains(position)) {
             customize_purple_.highlighted_ = false;
             customize_orange_.highlighted_ = true;
             customize_green_.highlighted_ = false;
             kObstacleColor = customize_orange_.color_;
         }
-        if (customize_green_.area_.contains(event.getPos())) {
+        if (customize_green_.area_.contains(position)) {
             customize_purple_.highlighted_ = false;
             customize_orange_.highlighted_ = false;
             customize_green_.highlighted_ = true;
@@ -297,16 +1019,16 @@ void GameEngine::mouseDown(const MouseEvent &event) {
         }
     }
     if (current_game_state_ == GameOverScreen) {
-        if (gameover_restart_.area_.contains(event.getPos())) {
+        if (gameover_restart_.area_.contains(position)) {
             ResetGame();
             current_game_state_ = StartScreen;
         }
-        if (gameover_leaderboard_.area_.contains(event.getPos())) {
+        if (gameover_leaderboard_.area_.contains(position)) {
             current_game_state_ = LeaderBoard;
         }
     }
     if (current_game_state_ == LeaderBoard) {
-        if (back_.area_.contains(event.getPos())) {
+        if (back_.area_.contains(position)) {
             ResetGame();
             current_game_state_ = StartScreen;
         }
@@ -315,26 +1037,34 @@ void GameEngine::mouseDown(const MouseEvent &event) {
 
 void GameEngine::ResetGame() {
     obstacles_.clear();
+    storm_obstacles_.clear();
+    particles_.Clear();
+    if (game_mode_ == Course) {
+        RestartCourse();
+    }
     bird_.has_collided_ = false;
     has_collided_ = false;
+    course_finished_ = false;
+    course_error_.clear();
     bird_.started_ = false;
     bird_.position_ = vec2(kX_Position, kInitialY_Position);
     bird_.acceleration_ = 0;
     bird_.y_velocity_ = 0;
     score_ = 0;
+    flock_.Reset(kInitialY_Position);
 }
 
 // Bird Constructor and Functions
 GameEngine::Bird::Bird(float set_x, float set_y, const char *set_color, float set_radius) {
     position_ = vec2(set_x, set_y);
-    color_ = (char *) set_color;
+    color_ = Color(set_color);
     radius_ = set_radius;
 }
 
 void GameEngine::Bird::Display() const {
-    color(Color(color_));
+    color(color_);
     drawSolidCircle(position_, radius_);
-    color(Color(kOutlineColor));
+    color(kOutlineColor);
     drawStrokedCircle(position_, radius_, kOutlineWidth, 0);
 }
 
@@ -348,33 +1078,46 @@ void GameEngine::Bird::UpdateBird() {
     }
 }
 
+// StormObstacle Functions
+float GameEngine::StormObstacle::GetRight() const {
+    return x_ + width_;
+}
+
+float GameEngine::StormObstacle::GetGapTop() const {
+    return gap_center_ - gap_size_ / 2;
+}
+
+float GameEngine::StormObstacle::GetGapBottom() const {
+    return gap_center_ + gap_size_ / 2;
+}
+
 // Ground Constructor and Functions
 GameEngine::Ground::Ground(Rectf set_top, Rectf set_bottom, const char * set_top_color, const char * set_bottom_color) {
     top_ = set_top;
     bottom_ = set_bottom;
-    top_color_ = (char *) set_top_color;
-    bottom_color_ = (char *) set_bottom_color;
+    top_color_ = Color(set_top_color);
+    bottom_color_ = Color(set_bottom_color);
 }
 
 void GameEngine::Ground::Display() const {
-    color(Color(top_color_));
+    color(top_color_);
     drawSolidRect(top_);
-    color(Color(bottom_color_));
+    color(bottom_color_);
     drawSolidRect(bottom_);
 }
 
 // Obstacle Constructor and Functions
 GameEngine::Obstacle::Obstacle(Rectf set_upper_main, Rectf set_lower_main, 
-                               Rectf set_upper_secondary, Rectf set_lower_secondary, const char * set_color) {
+                               Rectf set_upper_secondary, Rectf set_lower_secondary, const Color &set_color) {
     upper_main_ = set_upper_main;
     lower_main_ = set_lower_main;
     upper_secondary_ = set_upper_secondary;
     lower_secondary_ = set_lower_secondary;
-    color_ = (char *) set_color;
+    color_ = set_color;
 }
 
 void GameEngine::Obstacle::Display() const {
-    color(Color(color_));
+    color(color_);
     drawSolidRect(upper_main_);
     drawSolidRect(lower_main_);
     drawSolidRect(upper_secondary_);
@@ -385,49 +1128,73 @@ void GameEngine::Obstacle::Display() const {
 // Button Constructor and Functions
 GameEngine::Button::Button(Rectf set_area, const char *set_color, string set_title, float set_font_size) {
     area_ = set_area;
-    color_ = (char *) set_color;
+    color_ = Color(set_color);
     title_ = move(set_title);
     font_size_ = set_font_size;
 }
 
-void GameEngine::Button::Display() const {
-    color(Color(color_));
-    drawSolidRect(Rectf(area_.getUpperLeft(), area_.getLowerRight()));
-    Font button_font = Font(kGameFont, font_size_);
-    drawStringCentered(title_, vec2((area_.getX1() + area_.getX2()) / kPositionAverage, 
+void GameEngine::Button::LoadFont(const AssetPack *pack) {
+    font_.Load(kGameFont, font_size_, pack);
+}
+
+void GameEngine::Button::Display(bool highlighted) const {
+    color(color_);
+    drawSolidRect(area_);
+    font_.DrawCentered(title_, vec2((area_.getX1() + area_.getX2()) / kPositionAverage, 
                                     (area_.getY1() + area_.getY2()) / kPositionAverage - (font_size_ / 
                                     kTitlePositionDivider)), 
-                       kGameTextColor, button_font);
-    if (highlighted_) {
-        color(Color(kHighlightColor));
+                       kGameTextColor);
+    if (highlighted) {
+        color(kHighlightColor);
         drawStrokedRect(area_, (area_.getY2() - area_.getY1()) / kHighlightWidthDivider);
     }
 }
 
 // Leaderboard Constructor and Functions
-GameEngine::Leaderboard::Leaderboard() = default;
+GameEngine::Leaderboard::Leaderboard() {
+    for (size_t i = 0; i < kLeaderboardPositions; i++) {
+        rank_labels_.push_back(to_string(i + 1) + kDot);
+        score_labels_.push_back(to_string(scores_[i]));
+        score_labels_.back().reserve(kScoreTextCapacity);
+        displayed_scores_.push_back(scores_[i]);
+    }
+}
 
-void GameEngine::Leaderboard::Display() {
-    Font leaderboard_font = Font(kGameFont, kLeaderboardTitleFontSize);
-    drawStringCentered(kLeaderboardTitle, vec2(kLeaderboardTitleX_Position, kLeaderboardTitleY_Position), 
-                       kGameTextColor, leaderboard_font);
-    color(Color(kGameTextColor));
+void GameEngine::Leaderboard::LoadFonts(const AssetPack *pack) {
+    title_font_.Load(kGameFont, kLeaderboardTitleFontSize, pack);
+    score_font_.Load(kGameFont, kScoreFontSize, pack);
+}
+
+void GameEngine::Leaderboard::Display(const size_t* scores) const {
+    title_font_.DrawCentered(kLeaderboardTitle, vec2(kLeaderboardTitleX_Position, kLeaderboardTitleY_Position),
+                             kGameTextColor);
+    color(kGameTextColor);
     drawLine(vec2(kFirstLineX1_Position, kFirstLineY1_Position), vec2(kFirstLineX2_Position, 
                                                                       kFirstLineY1_Position));
     size_t line_gap = kLineGap;
     for (size_t i = 0; i < kLeaderboardPositions; i++) {
         drawLine(vec2(100, 150 + line_gap), vec2(500, 150 + line_gap));
-        Font kScoreFont = Font(kGameFont, 20);
-        drawStringCentered(to_string(i + 1) + kDot, vec2(100 + 20, 150 + line_gap - 20), 
-                           kGameTextColor, kScoreFont);
-        drawStringCentered(to_string(scores_[i]), vec2(500 - 50, 150 + line_gap - 20), 
-                           kGameTextColor, kScoreFont);
+        if (scores[i] != displayed_scores_[i]) {
+            char digits[kScoreTextCapacity];
+            snprintf(digits, sizeof(digits), "%zu", scores[i]);
+            score_labels_[i].assign(digits);
+            displayed_scores_[i] = scores[i];
+        }
+        score_font_.DrawCentered(rank_labels_[i], vec2(100 + 20, 150 + line_gap - 20), kGameTextColor);
+        score_font_.DrawCentered(score_labels_[i], vec2(500 - 50, 150 + line_gap - 20), kGameTextColor);
         line_gap += kLineGap;
     }
 }
 
-void GameEngine::Leaderboard::ManageScores() {
-    sort(scores_.begin(), scores_.end(), greater<size_t >());
+void GameEngine::Leaderboard::ManageScores(size_t new_score) {
+    if (new_score <= scores_.back()) {
+        return;
+    }
+    scores_.back() = new_score;
+    // the scores are already sorted so bubbling the new one up keeps them sorted
+    for (size_t i = scores_.size() - 1; i > 0 && scores_[i] > scores_[i - 1]; i--) {
+        std::swap(scores_[i], scores_[i - 1]);
+    }
 }
 
 // Functions for testing
@@ -439,6 +1206,10 @@ void GameEngine::SetGameState(GameEngine::GameState game_state) {
     current_game_state_ = game_state;
 }
 
+GameEngine::GameState GameEngine::GetGameState() const {
+    return current_game_state_;
+}
+
 size_t GameEngine::GetScore() const {
     return score_;
 }
@@ -451,6 +1222,18 @@ bool GameEngine::GetHasCollided() const {
     return has_collided_;
 }
 
+size_t GameEngine::GetParticleCount() const {
+    return particles_.GetCount();
+}
+
+void GameEngine::SetGameMode(GameEngine::GameMode game_mode) {
+    SelectMode(game_mode);
+}
+
+vector<GameEngine::StormObstacle> GameEngine::GetStormObstacles() {
+    return storm_obstacles_;
+}
+
 void GameEngine::Bird::SetStarted(bool set_started) {
     started_ = set_started;
 }
@@ -0,0 +1,73 @@
+#include <game_font.h>
+
+namespace flappybird {
+
+void GameFont::Load(const std::string &name, float size, const AssetPack *pack) {
+    pack_ = pack;
+    baked_ = pack != nullptr ? pack->FindFont(name, size) : nullptr;
+    if (baked_ == nullptr) {
+        font_ = ci::Font(name, size);
+        return;
+    }
+    // the atlas only stores coverage, the swizzle turns it into white texels with that alpha so the vertex color
+    // tints the text
+    ci::gl::Texture2d::Format format = ci::gl::Texture2d::Format().internalFormat(GL_R8)
+                                                                  .swizzleMask(GL_ONE, GL_ONE, GL_ONE, GL_RED)
+                                                                  .minFilter(GL_LINEAR).magFilter(GL_LINEAR);
+    atlas_ = ci::gl::Texture2d::create(pack->GetAtlas(*baked_), GL_RED, baked_->atlas_width_, 
+                                       baked_->atlas_height_, format);
+    shader_ = ci::gl::getStockShader(ci::gl::ShaderDef().texture().color());
+    batch_ = ci::gl::VertBatch::create(GL_TRIANGLES);
+}
+
+bool GameFont::IsBaked() const {
+    return baked_ != nullptr;
+}
+
+void GameFont::DrawCentered(const std::string &text, const glm::vec2 &position, const ci::ColorA &text_color) const {
+    if (baked_ == nullptr) {
+        ci::gl::drawStringCentered(text, position, text_color, font_);
+        return;
+    }
+    float width = 0;
+    for (char character : text) {
+        const BakedGlyph *glyph = pack_->GetGlyph(*baked_, character);
+        width += glyph != nullptr ? glyph->advance_ : 0;
+    }
+
+    // one quad per glyph in a reused batch, so a string is a single draw call and doesn't allocate once warm
+    float atlas_width = baked_->atlas_width_;
+    float atlas_height = baked_->atlas_height_;
+    float x = position.x - width / 2;
+    float top = position.y - baked_->baseline_offset_;
+    batch_->clear();
+    for (char character : text) {
+        const BakedGlyph *glyph = pack_->GetGlyph(*baked_, character);
+        if (glyph == nullptr) {
+            continue;
+        }
+        float left = glyph->atlas_x_ / atlas_width;
+        float right = (glyph->atlas_x_ + glyph->width_) / atlas_width;
+        float upper = glyph->atlas_y_ / atlas_height;
+        float lower = (glyph->atlas_y_ + glyph->height_) / atlas_height;
+        batch_->color(text_color);
+        batch_->texCoord(left, upper);
+        batch_->vertex(x, top);
+        batch_->texCoord(right, upper);
+        batch_->vertex(x + glyph->width_, top);
+        batch_->texCoord(right, lower);
+        batch_->vertex(x + glyph->width_, top + glyph->height_);
+        batch_->texCoord(left, upper);
+        batch_->vertex(x, top);
+        batch_->texCoord(right, lower);
+        batch_->vertex(x + glyph->width_, top + glyph->height_);
+        batch_->texCoord(left, lower);
+        batch_->vertex(x, top + glyph->height_);
+        x += glyph->advance_;
+    }
+    ci::gl::ScopedBlendAlpha blend;
+    ci::gl::ScopedGlslProg shader(shader_);
+    ci::gl::ScopedTextureBind texture(atlas_);
+    batch_->draw();
+}
+} // namespace flappybird
@@ -0,0 +1,116 @@
+#include <cmath>
+#include <particle_system.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FLAPPYBIRD_PARTICLES_SSE
+#endif
+
+namespace flappybird {
+
+static const float kTwoPi = 6.28318531f;
+
+ParticleSystem::ParticleSystem(size_t capacity) : capacity_(capacity), x_(capacity), y_(capacity), 
+                                                  velocity_x_(capacity), velocity_y_(capacity), life_(capacity), 
+                                                  kinds_(capacity) {
+}
+
+void ParticleSystem::Emit(Kind kind, float x, float y, size_t count, float speed, float lifetime) {
+    for (size_t i = 0; i < count && count_ < capacity_; i++, count_++) {
+        float angle = NextRandom() * kTwoPi;
+        float particle_speed = speed * NextRandom();
+        x_[count_] = x;
+        y_[count_] = y;
+        velocity_x_[count_] = particle_speed * cosf(angle);
+        velocity_y_[count_] = particle_speed * sinf(angle);
+        // particles in a burst fade out at slightly different times
+        life_[count_] = lifetime * (0.5f + 0.5f * NextRandom());
+        kinds_[count_] = kind;
+    }
+}
+
+void ParticleSystem::Update(float gravity, float time_step) {
+    Integrate(gravity, time_step);
+    RemoveDead();
+}
+
+void ParticleSystem::Integrate(float gravity, float time_step) {
+    float *x = x_.data();
+    float *y = y_.data();
+    float *velocity_x = velocity_x_.data();
+    float *velocity_y = velocity_y_.data();
+    float *life = life_.data();
+    size_t i = 0;
+#if defined(FLAPPYBIRD_PARTICLES_SSE)
+    const __m128 step = _mm_set1_ps(time_step);
+    const __m128 fall = _mm_set1_ps(gravity * time_step);
+    for (; i + 4 <= count_; i += 4) {
+        __m128 new_velocity_y = _mm_add_ps(_mm_loadu_ps(velocity_y + i), fall);
+        _mm_storeu_ps(velocity_y + i, new_velocity_y);
+        _mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(_mm_loadu_ps(velocity_x + i), step)));
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(new_velocity_y, step)));
+        _mm_storeu_ps(life + i, _mm_sub_ps(_mm_loadu_ps(life + i), step));
+    }
+#endif
+    // scalar tail, and the whole update on platforms without SSE
+    for (; i < count_; i++) {
+        velocity_y[i] += gravity * time_step;
+        x[i] += velocity_x[i] * time_step;
+        y[i] += velocity_y[i] * time_step;
+        life[i] -= time_step;
+    }
+}
+
+void ParticleSystem::RemoveDead() {
+    size_t i = 0;
+    while (i < count_) {
+        if (life_[i] > 0) {
+            i++;
+            continue;
+        }
+        // the last live particle takes the dead one's slot, so i is checked again
+        count_--;
+        x_[i] = x_[count_];
+        y_[i] = y_[count_];
+        velocity_x_[i] = velocity_x_[count_];
+        velocity_y_[i] = velocity_y_[count_];
+        life_[i] = life_[count_];
+        kinds_[i] = kinds_[count_];
+    }
+}
+
+void ParticleSystem::Clear() {
+    count_ = 0;
+}
+
+float ParticleSystem::NextRandom() {
+    random_state_ ^= random_state_ << 13;
+    random_state_ ^= random_state_ >> 17;
+    random_state_ ^= random_state_ << 5;
+    return (random_state_ >> 8) * (1.0f / 16777216.0f);
+}
+
+size_t ParticleSystem::GetCount() const {
+    return count_;
+}
+
+size_t ParticleSystem::GetCapacity() const {
+    return capacity_;
+}
+
+const float *ParticleSystem::GetX() const {
+    return x_.data();
+}
+
+const float *ParticleSystem::GetY() const {
+    return y_.data();
+}
+
+const float *ParticleSystem::GetLife() const {
+    return life_.data();
+}
+
+const ParticleSystem::Kind *ParticleSystem::GetKinds() const {
+    return kinds_.data();
+}
+} // namespace flappybird
@@ -0,0 +1,391 @@
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <asset_pack.h>
+#include <reachability.h>
+
+namespace flappybird {
+
+using std::vector;
+
+const float ReachabilityTable::kSafetyMargin = 2;
+
+// a bird that hasn't flapped for this many ticks is on the ground for any sane physics, only guards the arc loop
+static const size_t kMaxArcTicks = 10000;
+
+bool operator<(const FlightPhysics &left, const FlightPhysics &right) {
+    return std::tie(left.gravity_, left.flap_velocity_, left.obstacle_speed_, left.bird_radius_, left.obstacle_width_,
+                    left.obstacle_spacing_, left.gap_size_, left.ceiling_, left.ground_, left.min_gap_bottom_,
+                    left.max_gap_bottom_) <
+           std::tie(right.gravity_, right.flap_velocity_, right.obstacle_speed_, right.bird_radius_,
+                    right.obstacle_width_, right.obstacle_spacing_, right.gap_size_, right.ceiling_, right.ground_,
+                    right.min_gap_bottom_, right.max_gap_bottom_);
+}
+
+// clears every bit of a set outside [first, last], either end may lie outside the set
+static void KeepRange(vector<uint64_t> &bits, long first, long last) {
+    long num_bits = static_cast<long>(bits.size()) * 64;
+    first = std::max(first, 0L);
+    last = std::min(last, num_bits - 1);
+    if (first > last) {
+        std::fill(bits.begin(), bits.end(), 0);
+        return;
+    }
+    size_t first_word = static_cast<size_t>(first / 64);
+    size_t last_word = static_cast<size_t>(last / 64);
+    std::fill(bits.begin(), bits.begin() + first_word, 0);
+    std::fill(bits.begin() + last_word + 1, bits.end(), 0);
+    bits[first_word] &= ~0ULL << (first % 64);
+    bits[last_word] &= ~0ULL >> (63 - last % 64);
+}
+
+// target |= source moved up by shift bits, or down for a negative shift, bits moved past either end are lost
+static void OrShifted(vector<uint64_t> &target, const vector<uint64_t> &source, long shift) {
+    long word_shift = shift >= 0 ? shift / 64 : -((63 - shift) / 64);
+    int bit_shift = static_cast<int>(shift - word_shift * 64);
+    long num_words = static_cast<long>(target.size());
+    for (long word = 0; word < static_cast<long>(source.size()); word++) {
+        uint64_t bits = source[word];
+        if (bits == 0) {
+            continue;
+        }
+        long low = word + word_shift;
+        if (low >= 0 && low < num_words) {
+            target[low] |= bits << bit_shift;
+        }
+        if (bit_shift != 0 && low + 1 >= 0 && low + 1 < num_words) {
+            target[low + 1] |= bits >> (64 - bit_shift);
+        }
+    }
+}
+
+static bool TestBit(const vector<uint64_t> &bits, long bit) {
+    return bit >= 0 && bit < static_cast<long>(bits.size()) * 64 && (bits[bit / 64] >> (bit % 64) & 1);
+}
+
+// whether some flap sequence keeps a bird at y with velocity inside [low, high] for the next ticks, the positions are
+// followed exactly the way Bird::UpdateBird moves the bird
+static bool Survives(float y, float velocity, size_t ticks, float low, float high, const FlightPhysics &physics) {
+    if (ticks == 0) {
+        return true;
+    }
+    if (velocity > physics.flap_velocity_ / 2) {
+        float flapped = physics.flap_velocity_ + physics.gravity_;
+        if (y + flapped >= low && y + flapped <= high &&
+            Survives(y + flapped, flapped, ticks - 1, low, high, physics)) {
+            return true;
+        }
+    }
+    float falling = velocity + physics.gravity_;
+    return y + falling >= low && y + falling <= high && Survives(y + falling, falling, ticks - 1, low, high, physics);
+}
+
+// The flight search. Between flaps a bird follows the same arc whatever it did before, so a bird is known by the
+// height it flapped at and how many ticks ago that was: arcs_[k] holds one bit per flap height (row first_row_ + i
+// for bit i) of the birds that flapped k ticks ago. Only flapping rounds a height to a row, moving along an arc is
+// exact
+struct FlightSearch {
+    explicit FlightSearch(const FlightPhysics &physics);
+
+    // sets every height in [low, high] for the birds that are rising or falling no faster than a flap
+    void Start(float low, float high);
+
+    // one tick: every bird that may flap both flaps and doesn't, then the birds outside [low, high] are dropped
+    void Step(float low, float high);
+
+    // the rows of the birds k ticks into their arc that are between low and high
+    long FirstRow(size_t k, float low) const;
+    long LastRow(size_t k, float high) const;
+
+    const FlightPhysics &physics_;
+    // offsets_[k] and velocities_[k] are the height change and the velocity k ticks after a flap
+    vector<float> offsets_;
+    vector<float> velocities_;
+    // the youngest arc that may flap again and the oldest arc a bird can still be alive on
+    size_t ready_ = 0;
+    size_t max_age_ = 0;
+    long first_row_ = 0;
+    size_t num_words_ = 0;
+    vector<vector<uint64_t>> arcs_;
+    vector<uint64_t> flapped_;
+};
+
+FlightSearch::FlightSearch(const FlightPhysics &physics) : physics_(physics) {
+    float ceiling = physics.ceiling_ + ReachabilityTable::kSafetyMargin;
+    float ground = physics.ground_ - ReachabilityTable::kSafetyMargin;
+    offsets_.push_back(0);
+    velocities_.push_back(physics.flap_velocity_);
+    float highest = 0;
+    float lowest = 0;
+    // an arc ends once it drops further below its top than the ceiling is above the ground
+    while (offsets_.back() - highest <= ground - ceiling && offsets_.size() < kMaxArcTicks) {
+        velocities_.push_back(velocities_.back() + physics.gravity_);
+        offsets_.push_back(offsets_.back() + velocities_.back());
+        highest = std::min(highest, offsets_.back());
+        lowest = std::max(lowest, offsets_.back());
+    }
+    max_age_ = offsets_.size() - 1;
+    while (ready_ < max_age_ && velocities_[ready_] <= physics.flap_velocity_ / 2) {
+        ready_++;
+    }
+    first_row_ = static_cast<long>(std::floor(ceiling - lowest));
+    long last_row = static_cast<long>(std::ceil(ground - highest));
+    num_words_ = static_cast<size_t>(last_row - first_row_) / 64 + 1;
+    arcs_.assign(max_age_ + 1, vector<uint64_t>(num_words_, 0));
+    flapped_.assign(num_words_, 0);
+}
+
+long FlightSearch::FirstRow(size_t k, float low) const {
+    return static_cast<long>(std::ceil(low - offsets_[k])) - first_row_;
+}
+
+long FlightSearch::LastRow(size_t k, float high) const {
+    return static_cast<long>(std::floor(high - offsets_[k])) - first_row_;
+}
+
+void FlightSearch::Start(float low, float high) {
+    for (size_t k = 0; k <= max_age_; k++) {
+        bool gentle = velocities_[k] <= -physics_.flap_velocity_;
+        std::fill(arcs_[k].begin(), arcs_[k].end(), gentle ? ~0ULL : 0);
+        KeepRange(arcs_[k], FirstRow(k, low), LastRow(k, high));
+    }
+}
+
+void FlightSearch::Step(float low, float high) {
+    std::fill(flapped_.begin(), flapped_.end(), 0);
+    for (size_t k = ready_; k <= max_age_; k++) {
+        OrShifted(flapped_, arcs_[k], std::lround(offsets_[k]));
+    }
+    // every arc gets a tick older, the oldest can't be alive any more and is reused for the youngest
+    std::rotate(arcs_.begin(), arcs_.end() - 1, arcs_.end());
+    std::fill(arcs_[0].begin(), arcs_[0].end(), 0);
+    OrShifted(arcs_[1], flapped_, 0);
+    for (size_t k = 1; k <= max_age_; k++) {
+        KeepRange(arcs_[k], FirstRow(k, low), LastRow(k, high));
+    }
+}
+
+ReachabilityTable::ReachabilityTable(const FlightPhysics &physics) : physics_(physics) {
+    Allocate();
+    if (num_gaps_ == 0 || physics.gravity_ <= 0 || physics.obstacle_speed_ <= 0) {
+        return;
+    }
+
+    // the lips count as pipe for the whole width so a bird that clears them clears the pipe
+    size_t window_ticks = static_cast<size_t>(std::floor(physics.obstacle_width_ / physics.obstacle_speed_)) + 1;
+    float between = std::floor((physics.obstacle_spacing_ - physics.obstacle_width_) / physics.obstacle_speed_) - 1;
+    size_t between_ticks = static_cast<size_t>(std::max(between, 0.0f));
+    float ceiling = physics.ceiling_ + kSafetyMargin;
+    float ground = physics.ground_ - kSafetyMargin;
+    // heights inside a gap relative to its lower edge
+    float gap_low = -physics.gap_size_ + physics.bird_radius_ + kSafetyMargin;
+    float gap_high = -physics.bird_radius_ - kSafetyMargin;
+
+    FlightSearch search(physics);
+    // survivors[k] lists the heights relative to a gap's lower edge a bird k ticks after a flap can enter the gap at
+    // and still get through it, they are the same for every gap
+    vector<vector<long>> survivors(search.max_age_ + 1);
+    for (size_t k = 0; k <= search.max_age_; k++) {
+        for (long y = static_cast<long>(std::ceil(gap_low)); y <= static_cast<long>(std::floor(gap_high)); y++) {
+            if (Survives(static_cast<float>(y), search.velocities_[k], window_ticks, gap_low, gap_high, physics)) {
+                survivors[k].push_back(y);
+            }
+        }
+    }
+
+    vector<uint64_t> row(words_per_row_, 0);
+    for (size_t from = 0; from < num_gaps_; from++) {
+        float from_bottom = static_cast<float>(physics.min_gap_bottom_ + static_cast<int>(from));
+        float low = std::max(from_bottom + gap_low, ceiling);
+        float high = std::min(from_bottom + gap_high, ground);
+        search.Start(low, high);
+        for (size_t tick = 0; tick < window_ticks; tick++) {
+            search.Step(low, high);
+        }
+        for (size_t tick = 0; tick < between_ticks; tick++) {
+            search.Step(ceiling, ground);
+        }
+        // a bird at row r on arc k enters the next gap at first_row_ + r + offsets_[k], which is a gap with lower
+        // edge that height minus where in the gap the bird is
+        std::fill(row.begin(), row.end(), 0);
+        for (size_t k = 0; k <= search.max_age_; k++) {
+            long entry = search.first_row_ + std::lround(search.offsets_[k]) - physics.min_gap_bottom_;
+            for (long y : survivors[k]) {
+                OrShifted(row, search.arcs_[k], entry - y);
+            }
+        }
+        KeepRange(row, 0, static_cast<long>(num_gaps_) - 1);
+        std::copy(row.begin(), row.end(), reachable_.begin() + from * words_per_row_);
+
+        // the spawner draws from one range, the run of reachable gaps closest to staying level
+        long nearest = -1;
+        for (long distance = 0; distance < static_cast<long>(num_gaps_) && nearest < 0; distance++) {
+            for (long to : {static_cast<long>(from) - distance, static_cast<long>(from) + distance}) {
+                if (TestBit(row, to)) {
+                    nearest = to;
+                    break;
+                }
+            }
+        }
+        long first = nearest;
+        long last = nearest;
+        while (nearest >= 0 && TestBit(row, first - 1)) {
+            first--;
+        }
+        while (nearest >= 0 && TestBit(row, last + 1)) {
+            last++;
+        }
+        size_t count = 0;
+        for (uint64_t word : row) {
+            count += std::bitset<64>(word).count();
+        }
+        unused_transitions_ += count - static_cast<size_t>(nearest < 0 ? 0 : last - first + 1);
+        // nothing reachable leaves an empty range, first above last
+        next_ranges_[2 * from] = static_cast<int16_t>(nearest < 0 ? physics.max_gap_bottom_ + 1
+                                                                   : physics.min_gap_bottom_ + first);
+        next_ranges_[2 * from + 1] = static_cast<int16_t>(nearest < 0 ? physics.min_gap_bottom_ - 1
+                                                                       : physics.min_gap_bottom_ + last);
+    }
+}
+
+ReachabilityTable::ReachabilityTable(const BakedReachability &baked) : physics_(baked.physics_) {
+    Allocate();
+}
+
+void ReachabilityTable::Allocate() {
+    num_gaps_ = static_cast<size_t>(std::max(physics_.max_gap_bottom_ - physics_.min_gap_bottom_ + 1, 0));
+    words_per_row_ = num_gaps_ / 64 + 1;
+    reachable_.assign(num_gaps_ * words_per_row_, 0);
+    next_ranges_.assign(2 * num_gaps_, 0);
+}
+
+typedef std::shared_future<std::unique_ptr<ReachabilityTable>> TableFuture;
+
+// every table Get() has handed out, is building or was given by LoadBaked()
+static std::mutex table_mutex;
+static std::map<FlightPhysics, TableFuture> tables;
+
+const ReachabilityTable &ReachabilityTable::Get(const FlightPhysics &physics) {
+    // the lock only covers finding or claiming the table, the first caller builds it after letting go so lookups of
+    // other physics never wait on the search, later callers for the same physics wait on its future instead
+    std::promise<std::unique_ptr<ReachabilityTable>> built;
+    TableFuture table;
+    bool is_builder = false;
+    {
+        std::lock_guard<std::mutex> lock(table_mutex);
+        std::map<FlightPhysics, TableFuture>::iterator found = tables.find(physics);
+        if (found == tables.end()) {
+            table = built.get_future().share();
+            tables.emplace(physics, table);
+            is_builder = true;
+        } else {
+            table = found->second;
+        }
+    }
+    if (is_builder) {
+        built.set_value(std::unique_ptr<ReachabilityTable>(new ReachabilityTable(physics)));
+    }
+    return *table.get();
+}
+
+size_t ReachabilityTable::LoadBaked(const AssetPack &pack) {
+    size_t num_loaded = 0;
+    for (size_t i = 0; i < pack.GetReachabilityCount(); i++) {
+        const BakedReachability &baked = pack.GetReachability(i);
+        std::unique_ptr<ReachabilityTable> table(new ReachabilityTable(baked));
+        // a pack baked before the table layout changed is left for Get() to rebuild
+        if (baked.word_count_ != table->reachable_.size() || baked.range_count_ != table->next_ranges_.size()) {
+            continue;
+        }
+        const uint64_t *reachable = pack.GetReachableBits(baked);
+        const int16_t *next_ranges = pack.GetNextRanges(baked);
+        std::copy(reachable, reachable + baked.word_count_, table->reachable_.begin());
+        std::copy(next_ranges, next_ranges + baked.range_count_, table->next_ranges_.begin());
+        table->unused_transitions_ = baked.unused_transitions_;
+
+        std::promise<std::unique_ptr<ReachabilityTable>> loaded;
+        loaded.set_value(std::move(table));
+        std::lock_guard<std::mutex> lock(table_mutex);
+        num_loaded += tables.emplace(baked.physics_, loaded.get_future().share()).second;
+    }
+    return num_loaded;
+}
+
+void ReachabilityTable::Bake(AssetPackWriter &writer) const {
+    writer.AddReachability(physics_, reachable_, next_ranges_, static_cast<uint32_t>(unused_transitions_));
+}
+
+size_t ReachabilityTable::Index(int gap_bottom) const {
+    int clamped = std::min(std::max(gap_bottom, physics_.min_gap_bottom_), physics_.max_gap_bottom_);
+    return static_cast<size_t>(clamped - physics_.min_gap_bottom_);
+}
+
+bool ReachabilityTable::IsReachable(int from_gap_bottom, int to_gap_bottom) const {
+    if (num_gaps_ == 0 || to_gap_bottom < physics_.min_gap_bottom_ || to_gap_bottom > physics_.max_gap_bottom_) {
+        return false;
+    }
+    size_t to = static_cast<size_t>(to_gap_bottom - physics_.min_gap_bottom_);
+    return reachable_[Index(from_gap_bottom) * words_per_row_ + to / 64] >> (to % 64) & 1;
+}
+
+int ReachabilityTable::GetMinNext(int from_gap_bottom) const {
+    int min_next;
+    int max_next;
+    GetNextRange(from_gap_bottom, min_next, max_next);
+    return min_next;
+}
+
+int ReachabilityTable::GetMaxNext(int from_gap_bottom) const {
+    int min_next;
+    int max_next;
+    GetNextRange(from_gap_bottom, min_next, max_next);
+    return max_next;
+}
+
+void ReachabilityTable::GetNextRange(int from_gap_bottom, int &min_next, int &max_next) const {
+    if (num_gaps_ == 0) {
+        min_next = 1;
+        max_next = 0;
+        return;
+    }
+    const int16_t *range = &next_ranges_[2 * Index(from_gap_bottom)];
+    min_next = range[0];
+    max_next = range[1];
+}
+
+size_t ReachabilityTable::GetUnusedTransitions() const {
+    return unused_transitions_;
+}
+
+const FlightPhysics &ReachabilityTable::GetPhysics() const {
+    return physics_;
+}
+
+float PickGapBottom(const ReachabilityTable *table, float previous_gap_bottom, float lowest, size_t range,
+                    std::mt19937 &random) {
+    if (table == nullptr) {
+        return random() % range + lowest;
+    }
+    // gap edges are whole pixels, adding a half before truncating only guards against a stray rounding error
+    int from = static_cast<int>(previous_gap_bottom + 0.5f);
+    int low;
+    int high;
+    table->GetNextRange(from, low, high);
+    int first = static_cast<int>(lowest);
+    low = std::max(low, first);
+    high = std::min(high, first + static_cast<int>(range) - 1);
+    // a table for other physics that can't reach this range at all, no worse than before there were tables
+    if (low > high) {
+        return random() % range + lowest;
+    }
+    // scaling the 32 bit draw onto the range instead of taking it modulo the range keeps a division by a number
+    // that changes every spawn out of the spawner
+    uint64_t span = static_cast<uint64_t>(high - low + 1);
+    return static_cast<float>(low + static_cast<int>((static_cast<uint64_t>(random()) * span) >> 32));
+}
+} // namespace flappybird
@@ -0,0 +1,175 @@
+#include <sstream>
+#include <thread>
+#include <utility>
+#include <score_verifier.h>
+
+namespace flappybird {
+
+// how long a replay may keep going after the last flap before the run counts as never ending, long enough for
+// the bird to fall to the ground from anywhere even at storm tick rates
+static const size_t kSettleFrames = 2000;
+// the longest a bird can go from a flap to the ground, about 400 frames at storm tick rates, with room to spare
+static const size_t kLongestFallFrames = 1000;
+
+// the modes a submission can be replayed in, as they are named in the text form
+static const std::pair<GameEngine::GameMode, const char *> kModeNames[] = {
+        {GameEngine::Normal, "normal"}, {GameEngine::Challenge, "challenge"}, {GameEngine::PipeStorm, "storm"}};
+
+bool ParseSubmission(const string &line, Submission &submission) {
+    std::istringstream fields(line);
+    string mode;
+    if (!(fields >> submission.seed_ >> mode >> submission.claimed_score_)) {
+        return false;
+    }
+    bool known_mode = false;
+    for (const std::pair<GameEngine::GameMode, const char *> &mode_name : kModeNames) {
+        if (mode == mode_name.second) {
+            submission.mode_ = mode_name.first;
+            known_mode = true;
+        }
+    }
+    if (!known_mode) {
+        return false;
+    }
+    submission.flap_frames_.clear();
+    size_t frame;
+    while (fields >> frame) {
+        if (!submission.flap_frames_.empty() && frame < submission.flap_frames_.back()) {
+            return false;
+        }
+        submission.flap_frames_.push_back(frame);
+    }
+    return fields.eof();
+}
+
+string FormatSubmission(const Submission &submission) {
+    std::ostringstream line;
+    line << submission.seed_;
+    for (const std::pair<GameEngine::GameMode, const char *> &mode_name : kModeNames) {
+        if (submission.mode_ == mode_name.first) {
+            line << " " << mode_name.second;
+        }
+    }
+    line << " " << submission.claimed_score_;
+    for (size_t frame : submission.flap_frames_) {
+        line << " " << frame;
+    }
+    return line.str();
+}
+
+bool MakeSubmission(const GameEngine &game_engine, Submission &submission) {
+    GameEngine::GameMode mode = game_engine.GetGameMode();
+    if (mode == GameEngine::Course || game_engine.GetFlock().GetCount() > 0) {
+        return false;
+    }
+    submission.seed_ = game_engine.GetRunSeed();
+    submission.mode_ = mode;
+    submission.claimed_score_ = game_engine.GetScore();
+    submission.flap_frames_ = game_engine.GetRunFlapFrames();
+    return true;
+}
+
+Verdict VerifySubmission(const Submission &submission, GameEngine &game_engine) {
+    Verdict verdict;
+    const vector<size_t> &flap_frames = submission.flap_frames_;
+    // the bird hangs in place until its first flap, which is the press that left the start screen and always logged
+    // at frame 0, and can't stay up longer than a fall between flaps, so a log that breaks either rule would only
+    // keep a worker replaying and is refused before anything is simulated
+    if (flap_frames.empty() || flap_frames[0] != 0) {
+        return verdict;
+    }
+    for (size_t i = 1; i < flap_frames.size(); i++) {
+        if (flap_frames[i] - flap_frames[i - 1] > kLongestFallFrames + kSettleFrames) {
+            verdict.divergence_frame_ = flap_frames[i - 1] + kLongestFallFrames + kSettleFrames;
+            return verdict;
+        }
+    }
+    size_t frame_limit = (flap_frames.empty() ? 0 : flap_frames.back()) + kSettleFrames;
+    size_t next_flap = 0;
+    game_engine.StartRun(submission.seed_, submission.mode_);
+    for (size_t frame = 0; frame <= frame_limit; frame++) {
+        // input is applied before the tick, the same order the simulation thread uses
+        while (next_flap < flap_frames.size() && flap_frames[next_flap] == frame) {
+            game_engine.HandleKeyPress(KeyEvent::KEY_SPACE);
+            next_flap++;
+        }
+        game_engine.AdvanceOneFrame();
+        verdict.simulated_score_ = game_engine.GetScore();
+        verdict.divergence_frame_ = frame;
+        if (verdict.simulated_score_ > submission.claimed_score_) {
+            return verdict;
+        }
+        if (game_engine.GetGameState() == GameEngine::GameOverScreen) {
+            // flaps logged after the bird died can't have come from this run
+            verdict.accepted_ = verdict.simulated_score_ == submission.claimed_score_ && 
+                                next_flap == flap_frames.size();
+            return verdict;
+        }
+    }
+    return verdict;
+}
+
+SubmissionQueue::SubmissionQueue(size_t capacity) : capacity_(capacity) {
+}
+
+void SubmissionQueue::Push(Submission submission) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this] {
+        return submissions_.size() < capacity_ || closed_;
+    });
+    if (closed_) {
+        return;
+    }
+    submissions_.push_back(std::move(submission));
+    not_empty_.notify_one();
+}
+
+bool SubmissionQueue::Pop(Submission &submission) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this] {
+        return !submissions_.empty() || closed_;
+    });
+    if (submissions_.empty()) {
+        return false;
+    }
+    submission = std::move(submissions_.front());
+    submissions_.pop_front();
+    not_full_.notify_one();
+    return true;
+}
+
+void SubmissionQueue::Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    not_empty_.notify_all();
+    not_full_.notify_all();
+}
+
+ScoreVerifier::ScoreVerifier(size_t num_workers) {
+    num_workers_ = num_workers == 0 ? std::thread::hardware_concurrency() : num_workers;
+    if (num_workers_ == 0) {
+        num_workers_ = 1;
+    }
+    engines_.resize(num_workers_);
+}
+
+void ScoreVerifier::Run(SubmissionQueue &queue, const VerdictCallback &on_verdict) {
+    vector<std::thread> workers;
+    for (size_t i = 0; i < num_workers_; i++) {
+        GameEngine &game_engine = engines_[i];
+        workers.emplace_back([&queue, &on_verdict, &game_engine] {
+            Submission submission;
+            while (queue.Pop(submission)) {
+                on_verdict(submission, VerifySubmission(submission, game_engine));
+            }
+        });
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+size_t ScoreVerifier::GetWorkerCount() const {
+    return num_workers_;
+}
+} // namespace flappybird
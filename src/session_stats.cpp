@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <session_stats.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace flappybird {
+
+const size_t SessionStatsTracker::kFrameTimeSamples;
+const size_t SessionStatsTracker::kPercentileInterval;
+const size_t SessionStatsTracker::kDeathBuckets;
+const size_t StatsReader::kMaxReadAttempts;
+
+static const uint64_t kMicrosecondsPerSecond = 1000000;
+
+std::string StatsSegmentName(uint32_t pid) {
+    return kStatsNamePrefix + std::to_string(pid);
+}
+
+SessionStatsTracker::SessionStatsTracker() {
+    frame_times_.resize(kFrameTimeSamples);
+    sorted_frame_times_.reserve(kFrameTimeSamples);
+}
+
+void SessionStatsTracker::RecordTick(uint64_t now_us, float frame_time_us, bool died) {
+    if (!started_) {
+        started_ = true;
+        rate_window_start_us_ = now_us;
+        current_second_ = now_us / kMicrosecondsPerSecond;
+    }
+
+    frame_times_[next_frame_time_] = frame_time_us;
+    next_frame_time_ = (next_frame_time_ + 1) % kFrameTimeSamples;
+    num_frame_times_ = std::min(num_frame_times_ + 1, kFrameTimeSamples);
+    if (++ticks_since_percentiles_ >= kPercentileInterval) {
+        UpdatePercentiles();
+    }
+
+    // the tick that closes a window opens the next one
+    if (now_us - rate_window_start_us_ >= kMicrosecondsPerSecond) {
+        ticks_per_second_ = ticks_in_window_ * static_cast<float>(kMicrosecondsPerSecond) /
+                            (now_us - rate_window_start_us_);
+        ticks_in_window_ = 0;
+        rate_window_start_us_ = now_us;
+    }
+    ticks_in_window_++;
+
+    // seconds that passed since the last tick had no deaths, clearing their buckets drops them out of the minute
+    uint64_t second = now_us / kMicrosecondsPerSecond;
+    for (uint64_t skipped = 0; current_second_ < second && skipped < kDeathBuckets; skipped++) {
+        current_second_++;
+        uint32_t &bucket = death_buckets_[current_second_ % kDeathBuckets];
+        deaths_last_minute_ -= bucket;
+        bucket = 0;
+    }
+    current_second_ = second;
+    if (died && !was_dead_) {
+        deaths_++;
+        deaths_last_minute_++;
+        death_buckets_[current_second_ % kDeathBuckets]++;
+    }
+    was_dead_ = died;
+}
+
+void SessionStatsTracker::UpdatePercentiles() {
+    ticks_since_percentiles_ = 0;
+    sorted_frame_times_.assign(frame_times_.begin(), frame_times_.begin() + num_frame_times_);
+    auto percentile = [this](float fraction) {
+        std::vector<float>::iterator nth = sorted_frame_times_.begin() +
+                                           static_cast<size_t>(fraction * (sorted_frame_times_.size() - 1));
+        std::nth_element(sorted_frame_times_.begin(), nth, sorted_frame_times_.end());
+        return *nth;
+    };
+    frame_time_p50_us_ = percentile(0.5f);
+    frame_time_p90_us_ = percentile(0.9f);
+    frame_time_p99_us_ = percentile(0.99f);
+    frame_time_max_us_ = *std::max_element(sorted_frame_times_.begin(), sorted_frame_times_.end());
+}
+
+void SessionStatsTracker::Fill(SessionStats &stats) const {
+    stats.deaths_ = deaths_;
+    stats.deaths_per_minute_ = deaths_last_minute_;
+    stats.ticks_per_second_ = ticks_per_second_;
+    stats.frame_time_p50_us_ = frame_time_p50_us_;
+    stats.frame_time_p90_us_ = frame_time_p90_us_;
+    stats.frame_time_p99_us_ = frame_time_p99_us_;
+    stats.frame_time_max_us_ = frame_time_max_us_;
+}
+
+StatsPublisher::~StatsPublisher() {
+    Close();
+}
+
+bool StatsPublisher::IsOpen() const {
+    return block_ != nullptr;
+}
+
+void StatsPublisher::Publish(const SessionStats &stats) {
+    if (block_ == nullptr) {
+        return;
+    }
+    uint32_t words[kSessionStatsWords];
+    std::memcpy(words, &stats, sizeof(words));
+    // only this thread writes the sequence, so a relaxed load is enough to know its current value
+    uint32_t sequence = block_->sequence_.load(std::memory_order_relaxed);
+    block_->sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kSessionStatsWords; i++) {
+        block_->words_[i].store(words[i], std::memory_order_relaxed);
+    }
+    block_->sequence_.store(sequence + 2, std::memory_order_release);
+}
+
+StatsReader::~StatsReader() {
+    Close();
+}
+
+StatsReader::StatsReader(StatsReader &&other) noexcept {
+    *this = std::move(other);
+}
+
+StatsReader &StatsReader::operator=(StatsReader &&other) noexcept {
+    if (this != &other) {
+        Close();
+        std::swap(block_, other.block_);
+    }
+    return *this;
+}
+
+bool StatsReader::Read(SessionStats &stats) const {
+    if (block_ == nullptr) {
+        return false;
+    }
+    uint32_t words[kSessionStatsWords];
+    for (size_t attempt = 0; attempt < kMaxReadAttempts; attempt++) {
+        uint32_t before = block_->sequence_.load(std::memory_order_acquire);
+        if (before % 2 == 1) {
+            continue;
+        }
+        for (size_t i = 0; i < kSessionStatsWords; i++) {
+            words[i] = block_->words_[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (block_->sequence_.load(std::memory_order_relaxed) == before) {
+            std::memcpy(&stats, words, sizeof(words));
+            return true;
+        }
+    }
+    return false;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+uint32_t CurrentProcessId() {
+    return static_cast<uint32_t>(getpid());
+}
+
+bool StatsPublisher::Open(const std::string &name) {
+    Close();
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    void *mapping = MAP_FAILED;
+    if (ftruncate(fd, sizeof(StatsBlock)) == 0) {
+        mapping = mmap(nullptr, sizeof(StatsBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        return false;
+    }
+    block_ = static_cast<StatsBlock *>(mapping);
+    name_ = name;
+    // a segment left behind by a crashed process with the same pid is simply taken over
+    block_->sequence_.store(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < kSessionStatsWords; i++) {
+        block_->words_[i].store(0, std::memory_order_relaxed);
+    }
+    block_->version_ = kStatsVersion;
+    std::atomic_thread_fence(std::memory_order_release);
+    block_->magic_ = kStatsMagic;
+    return true;
+}
+
+void StatsPublisher::Close() {
+    if (block_ == nullptr) {
+        return;
+    }
+    munmap(block_, sizeof(StatsBlock));
+    shm_unlink(name_.c_str());
+    block_ = nullptr;
+}
+
+bool StatsReader::Open(const std::string &name) {
+    Close();
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    // the publisher may not have sized the segment yet, and touching a mapping past the end of it faults
+    struct stat segment_stat;
+    if (fstat(fd, &segment_stat) != 0 || static_cast<size_t>(segment_stat.st_size) < sizeof(StatsBlock)) {
+        close(fd);
+        return false;
+    }
+    void *mapping = mmap(nullptr, sizeof(StatsBlock), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    const StatsBlock *block = static_cast<const StatsBlock *>(mapping);
+    // pairs with the fence the publisher puts before writing the magic
+    bool initialized = block->magic_ == kStatsMagic;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!initialized || block->version_ != kStatsVersion) {
+        munmap(mapping, sizeof(StatsBlock));
+        return false;
+    }
+    block_ = block;
+    return true;
+}
+
+void StatsReader::Close() {
+    if (block_ != nullptr) {
+        munmap(const_cast<StatsBlock *>(block_), sizeof(StatsBlock));
+    }
+    block_ = nullptr;
+}
+
+#else
+
+uint32_t CurrentProcessId() {
+    return 0;
+}
+
+bool StatsPublisher::Open(const std::string &name) {
+    return false;
+}
+
+void StatsPublisher::Close() {
+}
+
+bool StatsReader::Open(const std::string &name) {
+    return false;
+}
+
+void StatsReader::Close() {
+}
+
+#endif
+} // namespace flappybird
@@ -0,0 +1,280 @@
+#include <spectator_server.h>
+
+#if defined(__linux__)
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace flappybird {
+
+const size_t SpectatorServer::kMaxPendingBytes;
+
+SpectatorServer::SpectatorServer() = default;
+
+SpectatorServer::~SpectatorServer() {
+    Stop();
+}
+
+bool SpectatorServer::IsRunning() const {
+    return running_;
+}
+
+uint16_t SpectatorServer::GetPort() const {
+    return port_;
+}
+
+size_t SpectatorServer::GetSubscriberCount() const {
+    return subscriber_count_;
+}
+
+#if defined(__linux__)
+
+// number of epoll events handled per wakeup
+static const int kMaxEvents = 256;
+// size of the buffer used to throw away anything a viewer sends
+static const size_t kDiscardBufferSize = 512;
+
+bool SpectatorServer::Start(uint16_t port) {
+    if (running_) {
+        return false;
+    }
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (listen_fd_ < 0 || epoll_fd_ < 0 || wake_fd_ < 0) {
+        Stop();
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    socklen_t address_size = sizeof(address);
+    if (bind(listen_fd_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        listen(listen_fd_, SOMAXCONN) != 0 ||
+        getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&address), &address_size) != 0) {
+        Stop();
+        return false;
+    }
+    port_ = ntohs(address.sin_port);
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = listen_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &event);
+    event.data.fd = wake_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+
+    running_ = true;
+    thread_ = std::thread(&SpectatorServer::Run, this);
+    return true;
+}
+
+void SpectatorServer::Stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        uint64_t wake = 1;
+        ssize_t written = write(wake_fd_, &wake, sizeof(wake));
+        (void) written;
+        thread_.join();
+    }
+    for (const auto &subscriber : subscribers_) {
+        close(subscriber.first);
+    }
+    subscribers_.clear();
+    subscriber_count_ = 0;
+    has_sent_ = false;
+    for (int *fd : {&listen_fd_, &epoll_fd_, &wake_fd_}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+void SpectatorServer::Publish(uint32_t tick, const SpectatorState &state) {
+    if (!running_) {
+        return;
+    }
+    TickState &slot = published_.GetWriteSlot();
+    slot.tick_ = tick;
+    slot.state_ = state;
+    published_.Publish();
+    uint64_t wake = 1;
+    ssize_t written = write(wake_fd_, &wake, sizeof(wake));
+    (void) written;
+}
+
+void SpectatorServer::Run() {
+    epoll_event events[kMaxEvents];
+    uint8_t discard[kDiscardBufferSize];
+    while (running_) {
+        int count = epoll_wait(epoll_fd_, events, kMaxEvents, -1);
+        if (count < 0 && errno != EINTR) {
+            break;
+        }
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+            if (fd == listen_fd_) {
+                AcceptSubscribers();
+            } else if (fd == wake_fd_) {
+                uint64_t wakes;
+                ssize_t wake_bytes = read(wake_fd_, &wakes, sizeof(wakes));
+                (void) wake_bytes;
+                BroadcastLatest();
+            } else {
+                auto subscriber = subscribers_.find(fd);
+                if (subscriber == subscribers_.end()) {
+                    continue;
+                }
+                if (events[i].events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) {
+                    disconnected_.push_back(fd);
+                    continue;
+                }
+                if (events[i].events & EPOLLIN) {
+                    // viewers have nothing to say, so anything they send is dropped
+                    ssize_t received;
+                    while ((received = recv(fd, discard, sizeof(discard), MSG_DONTWAIT)) > 0) {
+                    }
+                    if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                        disconnected_.push_back(fd);
+                        continue;
+                    }
+                }
+                if (events[i].events & EPOLLOUT) {
+                    FlushPending(fd, subscriber->second);
+                }
+            }
+        }
+        for (int fd : disconnected_) {
+            Disconnect(fd);
+        }
+        disconnected_.clear();
+    }
+}
+
+void SpectatorServer::AcceptSubscribers() {
+    int fd;
+    while ((fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        int no_delay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            continue;
+        }
+        Subscriber &subscriber = subscribers_[fd];
+        subscriber_count_++;
+        // a new viewer has nothing to apply deltas to, so it starts from a keyframe of the last broadcast tick
+        if (has_sent_) {
+            size_t size = EncodeSpectatorKeyframe(last_sent_.tick_, last_sent_.state_, frame_);
+            SendTo(fd, subscriber, frame_, size);
+        }
+    }
+}
+
+void SpectatorServer::BroadcastLatest() {
+    if (!published_.Update()) {
+        return;
+    }
+    const TickState &latest = published_.GetReadSlot();
+    // the frame is encoded once and the same bytes go to every subscriber
+    size_t size = has_sent_ ? EncodeSpectatorDelta(latest.tick_, last_sent_.state_, latest.state_, frame_)
+                            : EncodeSpectatorKeyframe(latest.tick_, latest.state_, frame_);
+    for (auto &subscriber : subscribers_) {
+        SendTo(subscriber.first, subscriber.second, frame_, size);
+    }
+    last_sent_ = latest;
+    has_sent_ = true;
+}
+
+void SpectatorServer::SendTo(int fd, Subscriber &subscriber, const uint8_t *data, size_t size) {
+    size_t sent = 0;
+    if (subscriber.pending_.size() == subscriber.pending_offset_) {
+        ssize_t result = send(fd, data, size, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            disconnected_.push_back(fd);
+            return;
+        }
+        sent = result < 0 ? 0 : static_cast<size_t>(result);
+        if (sent == size) {
+            return;
+        }
+    }
+
+    // the socket is full, keep the rest until epoll says it can take more
+    bool was_idle = subscriber.pending_.size() == subscriber.pending_offset_;
+    if (subscriber.pending_.size() - subscriber.pending_offset_ + size - sent > kMaxPendingBytes) {
+        disconnected_.push_back(fd);
+        return;
+    }
+    if (subscriber.pending_offset_ > 0) {
+        subscriber.pending_.erase(subscriber.pending_.begin(), subscriber.pending_.begin() + subscriber.pending_offset_);
+        subscriber.pending_offset_ = 0;
+    }
+    subscriber.pending_.insert(subscriber.pending_.end(), data + sent, data + size);
+    if (was_idle) {
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLRDHUP | EPOLLOUT;
+        event.data.fd = fd;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event);
+    }
+}
+
+void SpectatorServer::FlushPending(int fd, Subscriber &subscriber) {
+    while (subscriber.pending_offset_ < subscriber.pending_.size()) {
+        ssize_t result = send(fd, subscriber.pending_.data() + subscriber.pending_offset_,
+                              subscriber.pending_.size() - subscriber.pending_offset_, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (result < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                disconnected_.push_back(fd);
+            }
+            return;
+        }
+        subscriber.pending_offset_ += result;
+    }
+    subscriber.pending_.clear();
+    subscriber.pending_offset_ = 0;
+    epoll_event event = {};
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.fd = fd;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event);
+}
+
+void SpectatorServer::Disconnect(int fd) {
+    if (subscribers_.erase(fd) == 0) {
+        return;
+    }
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    subscriber_count_--;
+}
+
+#else
+
+bool SpectatorServer::Start(uint16_t port) {
+    return false;
+}
+
+void SpectatorServer::Stop() {
+}
+
+void SpectatorServer::Publish(uint32_t tick, const SpectatorState &state) {
+}
+
+void SpectatorServer::Run() {
+}
+
+#endif
+} // namespace flappybird
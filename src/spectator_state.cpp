@@ -0,0 +1,63 @@
+#include <cstring>
+#include <spectator_state.h>
+
+namespace flappybird {
+
+static const uint32_t kKeyframeMask = static_cast<uint32_t>((1ull << kSpectatorStateWords) - 1);
+
+size_t EncodeSpectatorDelta(uint32_t tick, const SpectatorState &previous, const SpectatorState &current,
+                            uint8_t *out) {
+    uint32_t previous_words[kSpectatorStateWords];
+    uint32_t current_words[kSpectatorStateWords];
+    memcpy(previous_words, &previous, sizeof(previous_words));
+    memcpy(current_words, &current, sizeof(current_words));
+
+    SpectatorFrameHeader header = {tick, 0};
+    size_t size = sizeof(header);
+    for (size_t i = 0; i < kSpectatorStateWords; i++) {
+        if (current_words[i] != previous_words[i]) {
+            header.mask_ |= 1u << i;
+            memcpy(out + size, &current_words[i], sizeof(uint32_t));
+            size += sizeof(uint32_t);
+        }
+    }
+    memcpy(out, &header, sizeof(header));
+    return size;
+}
+
+size_t EncodeSpectatorKeyframe(uint32_t tick, const SpectatorState &state, uint8_t *out) {
+    SpectatorFrameHeader header = {tick, kKeyframeMask};
+    memcpy(out, &header, sizeof(header));
+    memcpy(out + sizeof(header), &state, sizeof(state));
+    return sizeof(header) + sizeof(state);
+}
+
+size_t DecodeSpectatorFrame(const uint8_t *data, size_t size, SpectatorState &state, uint32_t &tick) {
+    if (size < sizeof(SpectatorFrameHeader)) {
+        return 0;
+    }
+    SpectatorFrameHeader header;
+    memcpy(&header, data, sizeof(header));
+    size_t num_words = 0;
+    for (uint32_t mask = header.mask_ & kKeyframeMask; mask != 0; mask &= mask - 1) {
+        num_words++;
+    }
+    size_t frame_size = sizeof(header) + num_words * sizeof(uint32_t);
+    if (size < frame_size) {
+        return 0;
+    }
+
+    uint32_t words[kSpectatorStateWords];
+    memcpy(words, &state, sizeof(words));
+    const uint8_t *next_word = data + sizeof(header);
+    for (size_t i = 0; i < kSpectatorStateWords; i++) {
+        if (header.mask_ & (1u << i)) {
+            memcpy(&words[i], next_word, sizeof(uint32_t));
+            next_word += sizeof(uint32_t);
+        }
+    }
+    memcpy(&state, words, sizeof(words));
+    tick = header.tick_;
+    return frame_size;
+}
+} // namespace flappybird
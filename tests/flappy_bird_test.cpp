@@ -1,7 +1,71 @@
 #include "catch2/catch.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <thread>
+#include <asset_pack.h>
+#include <course_file.h>
 #include <game_engine.h>
+#include <particle_system.h>
+#include <reachability.h>
+#include <score_verifier.h>
+#include <session_stats.h>
+#include <spectator_server.h>
+#include <spsc_queue.h>
+#include <triple_buffer.h>
+#if defined(__linux__)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
 
+// Counts every heap allocation in the test binary so tests can check the game loop never allocates
+static std::atomic<size_t> allocation_count(0);
+
+void *operator new(size_t size) {
+    allocation_count++;
+    void *memory = std::malloc(size == 0 ? 1 : size);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void operator delete(void *memory) noexcept {
+    std::free(memory);
+}
+
+using flappybird::AssetPack;
+using flappybird::AssetPackWriter;
+using flappybird::BakedFont;
+using flappybird::BakedGlyph;
+using flappybird::CourseFile;
+using flappybird::CoursePipe;
+using flappybird::FlightPhysics;
 using flappybird::GameEngine;
+using flappybird::ParticleSystem;
+using flappybird::PickGapBottom;
+using flappybird::ReachabilityTable;
+using flappybird::ScoreVerifier;
+using flappybird::SessionStats;
+using flappybird::SessionStatsTracker;
+using flappybird::Submission;
+using flappybird::SubmissionQueue;
+using flappybird::Verdict;
+using flappybird::SpectatorServer;
+using flappybird::SpectatorState;
+using flappybird::SpscQueue;
+using flappybird::StatsPublisher;
+using flappybird::StatsReader;
+using flappybird::TripleBuffer;
+using flappybird::VerifySubmission;
 
 TEST_CASE("UpdateObstacleVector") {
     GameEngine game_engine;
@@ -80,3 +144,1075 @@ TEST_CASE("HandleCollision") {
     REQUIRE(game_engine.GetHasCollided() == true);
   }
 }
+
+TEST_CASE("HandleInput") {
+  SECTION("Forwarded Space Key Starts the Game") {
+    GameEngine game_engine;
+    GameEngine::InputEvent input;
+    input.type_ = GameEngine::InputEvent::KeyPress;
+    input.key_code_ = KeyEvent::KEY_SPACE;
+    game_engine.HandleInput(input);
+    GameEngine::Snapshot snapshot;
+    game_engine.WriteSnapshot(snapshot);
+    REQUIRE(snapshot.game_state_ == GameEngine::GameScreen);
+  }
+  SECTION("Forwarded Click Selects Challenge Mode") {
+    GameEngine game_engine;
+    GameEngine::InputEvent input;
+    input.type_ = GameEngine::InputEvent::Click;
+    input.position_ = vec2(500, 440);
+    game_engine.HandleInput(input);
+    GameEngine::Snapshot snapshot;
+    game_engine.WriteSnapshot(snapshot);
+    REQUIRE(snapshot.challenge_highlighted_);
+    REQUIRE_FALSE(snapshot.normal_highlighted_);
+  }
+}
+
+TEST_CASE("WriteSnapshot") {
+  SECTION("Snapshot Copies Obstacles and Score") {
+    GameEngine game_engine;
+    game_engine.SetGameState(flappybird::GameEngine::GameScreen);
+    game_engine.AdvanceOneFrame();
+    GameEngine::Snapshot snapshot;
+    game_engine.WriteSnapshot(snapshot);
+    REQUIRE(snapshot.num_obstacles_ == 2);
+    REQUIRE(snapshot.obstacles_[0].upper_main_.getX1() == game_engine.GetObstacles()[0].upper_main_.getX1());
+    REQUIRE(snapshot.score_ == 0);
+  }
+  SECTION("Snapshot Holds Exactly the Flock") {
+    GameEngine game_engine;
+    GameEngine::Snapshot snapshot;
+    game_engine.WriteSnapshot(snapshot);
+    REQUIRE(snapshot.flock_y_.empty());
+    for (size_t i = 0; i < 3; i++) {
+        game_engine.AddFlockBird(flappybird::Flock::kNoKey, nullptr, Color("white"));
+    }
+    game_engine.WriteSnapshot(snapshot);
+    REQUIRE(snapshot.flock_y_.size() == 3);
+    REQUIRE(snapshot.flock_colors_.size() == 3);
+    REQUIRE(snapshot.flock_y_[2] == game_engine.GetFlock().GetY()[2]);
+    game_engine.ClearFlock();
+    game_engine.WriteSnapshot(snapshot);
+    REQUIRE(snapshot.flock_y_.empty());
+    REQUIRE(snapshot.flock_colors_.empty());
+  }
+}
+
+TEST_CASE("TripleBuffer") {
+    TripleBuffer<int> buffer;
+  SECTION("Reader Sees Nothing New Before a Publish") {
+    REQUIRE_FALSE(buffer.Update());
+  }
+  SECTION("Reader Gets the Newest Published Value") {
+    buffer.GetWriteSlot() = 1;
+    buffer.Publish();
+    buffer.GetWriteSlot() = 2;
+    buffer.Publish();
+    REQUIRE(buffer.Update());
+    REQUIRE(buffer.GetReadSlot() == 2);
+    REQUIRE_FALSE(buffer.Update());
+    REQUIRE(buffer.GetReadSlot() == 2);
+  }
+  SECTION("Writer Never Overwrites the Read Slot") {
+    buffer.GetWriteSlot() = 1;
+    buffer.Publish();
+    buffer.Update();
+    for (int i = 2; i < 10; i++) {
+        buffer.GetWriteSlot() = i;
+        buffer.Publish();
+        REQUIRE(buffer.GetReadSlot() == 1);
+    }
+  }
+}
+
+TEST_CASE("SpscQueue") {
+    SpscQueue<int, 4> queue;
+    int value = 0;
+  SECTION("Pop From Empty Queue Fails") {
+    REQUIRE_FALSE(queue.Pop(value));
+  }
+  SECTION("Elements Come Out in Order") {
+    queue.Push(1);
+    queue.Push(2);
+    REQUIRE(queue.Pop(value));
+    REQUIRE(value == 1);
+    REQUIRE(queue.Pop(value));
+    REQUIRE(value == 2);
+  }
+  SECTION("Push to Full Queue Fails") {
+    for (int i = 0; i < 4; i++) {
+        REQUIRE(queue.Push(i));
+    }
+    REQUIRE_FALSE(queue.Push(4));
+  }
+}
+
+TEST_CASE("SpectatorFrames") {
+    SpectatorState previous;
+    previous.score_ = 3;
+    previous.bird_y_ = 250;
+    previous.num_obstacles_ = 2;
+    previous.obstacles_[0].x_ = 400;
+    SpectatorState current = previous;
+    current.bird_y_ = 254;
+    current.obstacles_[0].x_ = 398;
+    uint8_t frame[flappybird::kMaxSpectatorFrameSize];
+  SECTION("Keyframe Rebuilds the Whole State") {
+    size_t size = flappybird::EncodeSpectatorKeyframe(7, current, frame);
+    SpectatorState decoded;
+    uint32_t tick = 0;
+    REQUIRE(flappybird::DecodeSpectatorFrame(frame, size, decoded, tick) == size);
+    REQUIRE(tick == 7);
+    REQUIRE(decoded.score_ == 3);
+    REQUIRE(decoded.bird_y_ == 254);
+    REQUIRE(decoded.obstacles_[0].x_ == 398);
+  }
+  SECTION("Delta Only Holds Changed Words") {
+    size_t size = flappybird::EncodeSpectatorDelta(8, previous, current, frame);
+    REQUIRE(size == sizeof(flappybird::SpectatorFrameHeader) + 2 * sizeof(uint32_t));
+    SpectatorState decoded = previous;
+    uint32_t tick = 0;
+    REQUIRE(flappybird::DecodeSpectatorFrame(frame, size, decoded, tick) == size);
+    REQUIRE(tick == 8);
+    REQUIRE(decoded.bird_y_ == 254);
+    REQUIRE(decoded.obstacles_[0].x_ == 398);
+    REQUIRE(decoded.num_obstacles_ == 2);
+  }
+  SECTION("Incomplete Frame Is Not Decoded") {
+    size_t size = flappybird::EncodeSpectatorDelta(8, previous, current, frame);
+    SpectatorState decoded;
+    uint32_t tick = 0;
+    REQUIRE(flappybird::DecodeSpectatorFrame(frame, size - 1, decoded, tick) == 0);
+  }
+}
+
+#if defined(__linux__)
+TEST_CASE("SpectatorServer") {
+  SECTION("Viewer Reconstructs Published States") {
+    SpectatorServer server;
+    REQUIRE(server.Start(0));
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(server.GetPort());
+    REQUIRE(connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0);
+    while (server.GetSubscriberCount() == 0) {
+        std::this_thread::yield();
+    }
+
+    GameEngine game_engine;
+    game_engine.SetGameState(flappybird::GameEngine::GameScreen);
+    SpectatorState state;
+    for (uint32_t tick = 0; tick < 5; tick++) {
+        game_engine.AdvanceOneFrame();
+        game_engine.WriteSpectatorState(state);
+        server.Publish(tick, state);
+    }
+
+    SpectatorState decoded;
+    uint32_t tick = 0;
+    std::vector<uint8_t> received;
+    uint8_t buffer[1024];
+    size_t offset = 0;
+    while (tick != 4) {
+        ssize_t size = recv(fd, buffer, sizeof(buffer), 0);
+        REQUIRE(size > 0);
+        received.insert(received.end(), buffer, buffer + size);
+        size_t frame_size;
+        while ((frame_size = flappybird::DecodeSpectatorFrame(received.data() + offset, received.size() - offset,
+                                                               decoded, tick)) != 0) {
+            offset += frame_size;
+        }
+    }
+    close(fd);
+    REQUIRE(decoded.game_state_ == flappybird::GameEngine::GameScreen);
+    REQUIRE(decoded.num_obstacles_ == 2);
+    REQUIRE(decoded.obstacles_[1].gap_bottom_ == state.obstacles_[1].gap_bottom_);
+    REQUIRE(decoded.bird_y_ == state.bird_y_);
+  }
+}
+#endif
+
+// flaps whenever the bird sinks close to the bottom of the next gap until it has scored a few points, then lets
+// it fall so that deaths, the leaderboard and restarts are part of the loop too
+static void PlayOneFrame(GameEngine &game_engine, SpectatorState &state, GameEngine::Snapshot &snapshot) {
+    game_engine.WriteSpectatorState(state);
+    if (state.game_state_ != flappybird::GameEngine::GameScreen) {
+        game_engine.HandleKeyPress(KeyEvent::KEY_SPACE);
+    } else if (state.score_ < 3) {
+        for (uint32_t i = 0; i < state.num_obstacles_; i++) {
+            if (state.obstacles_[i].x_ + 60 >= state.bird_x_) {
+                if (state.bird_y_ > state.obstacles_[i].gap_bottom_ - 25) {
+                    game_engine.HandleKeyPress(KeyEvent::KEY_SPACE);
+                }
+                break;
+            }
+        }
+    }
+    game_engine.AdvanceOneFrame();
+    game_engine.WriteSnapshot(snapshot);
+}
+
+TEST_CASE("SteadyStateAllocations") {
+  SECTION("Game Loop Does Not Allocate After Warm Up") {
+    GameEngine game_engine;
+    SpectatorState state;
+    GameEngine::Snapshot snapshot;
+    for (size_t i = 0; i < 5000; i++) {
+        PlayOneFrame(game_engine, state, snapshot);
+    }
+    size_t allocations_before = allocation_count;
+    for (size_t i = 0; i < 100000; i++) {
+        PlayOneFrame(game_engine, state, snapshot);
+    }
+    REQUIRE(allocation_count == allocations_before);
+  }
+}
+
+// keeps storm runs going for a number of ticks, flapping whenever the bird sinks below the middle of the window
+// and starting a new run once it is down, so the storm keeps scrolling
+static void FlyStorm(GameEngine &game_engine, size_t ticks) {
+    for (size_t i = 0; i < ticks; i++) {
+        if (game_engine.GetGameState() != GameEngine::GameScreen) {
+            game_engine.StartRun(static_cast<unsigned>(i), GameEngine::PipeStorm);
+        }
+        if (game_engine.GetBird().position_.y >= 300) {
+            game_engine.HandleKeyPress(KeyEvent::KEY_SPACE);
+        }
+        game_engine.AdvanceOneFrame();
+    }
+}
+
+TEST_CASE("PipeStorm") {
+    GameEngine game_engine;
+    game_engine.SetGameMode(flappybird::GameEngine::PipeStorm);
+    game_engine.SetGameState(flappybird::GameEngine::GameScreen);
+  SECTION("Storm Spawns All Obstacles and Ticks at 240 Hz") {
+    game_engine.AdvanceOneFrame();
+    REQUIRE(game_engine.GetStormObstacles().size() == 1000);
+    REQUIRE(game_engine.GetTicksPerSecond() == 240);
+  }
+  SECTION("Storm Waits for the First Flap") {
+    game_engine.AdvanceOneFrame();
+    vector<GameEngine::StormObstacle> before = game_engine.GetStormObstacles();
+    for (size_t i = 0; i < 1000; i++) {
+        game_engine.AdvanceOneFrame();
+    }
+    vector<GameEngine::StormObstacle> after = game_engine.GetStormObstacles();
+    REQUIRE(after.size() == before.size());
+    for (size_t i = 0; i < after.size(); i++) {
+        REQUIRE(after[i].x_ == before[i].x_);
+    }
+    REQUIRE_FALSE(game_engine.GetHasCollided());
+    REQUIRE(game_engine.GetScore() == 0);
+    game_engine.HandleKeyPress(KeyEvent::KEY_SPACE);
+    game_engine.AdvanceOneFrame();
+    REQUIRE(game_engine.GetStormObstacles()[0].x_ < before[0].x_);
+  }
+  SECTION("Storm Obstacles Stay Sorted for the Broadphase") {
+    FlyStorm(game_engine, 5000);
+    vector<GameEngine::StormObstacle> obstacles = game_engine.GetStormObstacles();
+    REQUIRE(obstacles.size() == 1000);
+    for (size_t i = 1; i < obstacles.size(); i++) {
+        REQUIRE(obstacles[i - 1].x_ <= obstacles[i].x_);
+    }
+  }
+  SECTION("Snapshot Holds Every Obstacle Inside the Window") {
+    GameEngine::Snapshot snapshot;
+    for (size_t run = 0; run < 4; run++) {
+        FlyStorm(game_engine, 600);
+        game_engine.WriteSnapshot(snapshot);
+        size_t num_visible = 0;
+        for (const GameEngine::StormObstacle &obstacle : game_engine.GetStormObstacles()) {
+            num_visible += obstacle.GetRight() >= 0 && obstacle.x_ <= 600;
+        }
+        // the storm is dense enough that hundreds of pipes share the window
+        REQUIRE(num_visible > 100);
+        REQUIRE(snapshot.num_obstacles_ == num_visible);
+        for (size_t i = 0; i < snapshot.num_obstacles_; i++) {
+            REQUIRE(snapshot.obstacles_[i].upper_main_.getX2() >= 0);
+            REQUIRE(snapshot.obstacles_[i].upper_main_.getX1() <= 600);
+        }
+    }
+  }
+  SECTION("Bird Is Hit by a Passing Storm Pipe") {
+    // hovering low, under every gap, the first pipe that reaches the bird hits it well above the ground
+    game_engine.HandleKeyPress(KeyEvent::KEY_SPACE);
+    for (size_t i = 0; i < 2400 && !game_engine.GetHasCollided(); i++) {
+        if (game_engine.GetBird().position_.y >= 540) {
+            game_engine.HandleKeyPress(KeyEvent::KEY_SPACE);
+        }
+        game_engine.AdvanceOneFrame();
+    }
+    REQUIRE(game_engine.GetHasCollided());
+    REQUIRE(game_engine.GetBird().position_.y < 560);
+  }
+  SECTION("A Gap Following Bot Survives the Storm") {
+    game_engine.AddFlockBird(flappybird::Flock::kNoKey, std::make_shared<flappybird::GapFollower>(20), 
+                             Color("white"));
+    for (unsigned seed = 0; seed < 5; seed++) {
+        game_engine.StartRun(seed, GameEngine::PipeStorm);
+        // the storm reaches the bird within a few hundred ticks, this is well over ten seconds of it
+        for (size_t i = 0; i < 3000; i++) {
+            game_engine.AdvanceOneFrame();
+        }
+        REQUIRE(game_engine.GetFlock().GetAliveCount() == 1);
+        REQUIRE(game_engine.GetScore() > 100);
+    }
+  }
+  SECTION("Storm Holds a 240 Hz Tick With 1000 Obstacles") {
+    auto start = std::chrono::steady_clock::now();
+    FlyStorm(game_engine, 2400);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    // 2400 ticks are ten seconds of storm, the simulation has to get through them faster than real time
+    REQUIRE(elapsed.count() < 10);
+  }
+}
+
+TEST_CASE("ParticleSystem") {
+    ParticleSystem particles(100);
+  SECTION("Emit Stops at Capacity") {
+    particles.Emit(ParticleSystem::Spark, 10, 10, 150, 2, 20);
+    REQUIRE(particles.GetCount() == 100);
+  }
+  SECTION("Particles Move and Fall") {
+    particles.Emit(ParticleSystem::Feather, 10, 10, 1, 0, 20);
+    particles.Update(1, 1);
+    REQUIRE(particles.GetX()[0] == 10);
+    REQUIRE(particles.GetY()[0] == 11);
+  }
+  SECTION("Dead Particles Are Removed and Live Ones Kept") {
+    particles.Emit(ParticleSystem::Spark, 10, 10, 7, 2, 2);
+    particles.Emit(ParticleSystem::Debris, 50, 50, 9, 0, 100);
+    for (size_t i = 0; i < 2; i++) {
+        particles.Update(0, 1);
+    }
+    REQUIRE(particles.GetCount() == 9);
+    for (size_t i = 0; i < particles.GetCount(); i++) {
+        REQUIRE(particles.GetKinds()[i] == ParticleSystem::Debris);
+        REQUIRE(particles.GetX()[i] == 50);
+    }
+  }
+}
+
+TEST_CASE("ParticleEffects") {
+  SECTION("Flapping Emits Feathers") {
+    GameEngine game_engine;
+    game_engine.HandleKeyPress(KeyEvent::KEY_SPACE);
+    game_engine.HandleKeyPress(KeyEvent::KEY_SPACE);
+    REQUIRE(game_engine.GetParticleCount() > 0);
+    GameEngine::Snapshot snapshot;
+    game_engine.WriteSnapshot(snapshot);
+    REQUIRE(snapshot.num_particles_ == game_engine.GetParticleCount());
+    REQUIRE(snapshot.particle_kinds_[0] == ParticleSystem::Feather);
+  }
+}
+
+// plays a run with a bot that aims for the bottom of the next gap until it reaches target_score, recording every
+// flap so the run can be submitted
+static Submission RecordRun(unsigned seed, size_t target_score) {
+    GameEngine game_engine;
+    game_engine.StartRun(seed, flappybird::GameEngine::Normal);
+    Submission submission;
+    submission.seed_ = seed;
+    SpectatorState state;
+    for (size_t frame = 0; game_engine.GetGameState() == flappybird::GameEngine::GameScreen; frame++) {
+        game_engine.WriteSpectatorState(state);
+        if (frame == 0) {
+            // the bird hangs in place until its first flap
+            game_engine.HandleKeyPress(KeyEvent::KEY_SPACE);
+            submission.flap_frames_.push_back(frame);
+        }
+        for (uint32_t i = 0; i < state.num_obstacles_ && state.score_ < target_score; i++) {
+            if (state.obstacles_[i].x_ + 60 >= state.bird_x_) {
+                if (state.bird_y_ > state.obstacles_[i].gap_bottom_ - 25) {
+                    game_engine.HandleKeyPress(KeyEvent::KEY_SPACE);
+                    submission.flap_frames_.push_back(frame);
+                }
+                break;
+            }
+        }
+        game_engine.AdvanceOneFrame();
+    }
+    submission.claimed_score_ = game_engine.GetScore();
+    return submission;
+}
+
+TEST_CASE("ScoreVerifier") {
+    Submission honest = RecordRun(42, 4);
+    GameEngine game_engine;
+  SECTION("Recorded Run Scores") {
+    REQUIRE(honest.claimed_score_ == 4);
+  }
+  SECTION("Honest Claim Is Accepted") {
+    Verdict verdict = VerifySubmission(honest, game_engine);
+    REQUIRE(verdict.accepted_);
+    REQUIRE(verdict.simulated_score_ == 4);
+  }
+  SECTION("Inflated Claim Is Rejected at the Frame the Bird Died") {
+    Verdict honest_verdict = VerifySubmission(honest, game_engine);
+    Submission inflated = honest;
+    inflated.claimed_score_ = 9;
+    Verdict verdict = VerifySubmission(inflated, game_engine);
+    REQUIRE_FALSE(verdict.accepted_);
+    REQUIRE(verdict.divergence_frame_ == honest_verdict.divergence_frame_);
+  }
+  SECTION("Understated Claim Is Rejected Where the Replay Passes It") {
+    Submission understated = honest;
+    understated.claimed_score_ = 2;
+    Verdict verdict = VerifySubmission(understated, game_engine);
+    REQUIRE_FALSE(verdict.accepted_);
+    REQUIRE(verdict.simulated_score_ == 3);
+  }
+  SECTION("Flap Logs No Run Can Produce Are Rejected Without a Replay") {
+    Submission late_start;
+    REQUIRE(flappybird::ParseSubmission("42 normal 0 18446744073709549615", late_start));
+    Submission long_gap;
+    REQUIRE(flappybird::ParseSubmission("42 storm 0 0 18446744073709549615", long_gap));
+    Submission no_flaps;
+    REQUIRE(flappybird::ParseSubmission("42 challenge 0", no_flaps));
+    auto start = std::chrono::steady_clock::now();
+    for (const Submission &submission : {late_start, long_gap, no_flaps}) {
+        REQUIRE_FALSE(VerifySubmission(submission, game_engine).accepted_);
+    }
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+  }
+  SECTION("Claim Replayed With the Wrong Seed Is Rejected") {
+    Submission wrong_seed = honest;
+    wrong_seed.seed_ = 43;
+    REQUIRE_FALSE(VerifySubmission(wrong_seed, game_engine).accepted_);
+  }
+  SECTION("Runs Played From the Start Screen Export and Verify") {
+    size_t total_score = 0;
+    for (GameEngine::GameMode mode : {GameEngine::Normal, GameEngine::Challenge, GameEngine::PipeStorm}) {
+        GameEngine player;
+        player.SetGameMode(mode);
+        // two runs in a row like in the app, the second one starts from whatever the first left behind
+        for (size_t run = 0; run < 2; run++) {
+            REQUIRE(player.GetGameState() == GameEngine::StartScreen);
+            player.HandleKeyPress(KeyEvent::KEY_SPACE);
+            SpectatorState state;
+            while (player.GetGameState() == GameEngine::GameScreen) {
+                player.WriteSpectatorState(state);
+                for (uint32_t i = 0; i < state.num_obstacles_ && state.score_ < 3; i++) {
+                    if (state.obstacles_[i].x_ + 60 >= state.bird_x_) {
+                        if (state.bird_y_ > state.obstacles_[i].gap_bottom_ - 25) {
+                            player.HandleKeyPress(KeyEvent::KEY_SPACE);
+                        }
+                        break;
+                    }
+                }
+                player.AdvanceOneFrame();
+            }
+            Submission submission;
+            REQUIRE(flappybird::MakeSubmission(player, submission));
+            REQUIRE(submission.mode_ == mode);
+            Submission parsed;
+            REQUIRE(flappybird::ParseSubmission(flappybird::FormatSubmission(submission), parsed));
+            Verdict verdict = VerifySubmission(parsed, game_engine);
+            REQUIRE(verdict.accepted_);
+            REQUIRE(verdict.simulated_score_ == player.GetScore());
+            total_score += player.GetScore();
+            player.HandleKeyPress(KeyEvent::KEY_SPACE);
+        }
+    }
+    REQUIRE(total_score > 0);
+  }
+  SECTION("Flock Runs Are Not Submitted") {
+    GameEngine player;
+    player.AddFlockBird(KeyEvent::KEY_SPACE, nullptr, Color("yellow"));
+    player.StartRun(1, GameEngine::Normal);
+    Submission submission;
+    REQUIRE_FALSE(flappybird::MakeSubmission(player, submission));
+  }
+  SECTION("Submission Text Round Trips") {
+    Submission parsed;
+    REQUIRE(flappybird::ParseSubmission("42 challenge 3 10 40 41", parsed));
+    REQUIRE(parsed.seed_ == 42);
+    REQUIRE(parsed.mode_ == flappybird::GameEngine::Challenge);
+    REQUIRE(parsed.claimed_score_ == 3);
+    REQUIRE(parsed.flap_frames_ == vector<size_t>({10, 40, 41}));
+    REQUIRE(flappybird::FormatSubmission(parsed) == "42 challenge 3 10 40 41");
+    REQUIRE_FALSE(flappybird::ParseSubmission("# comment", parsed));
+    REQUIRE_FALSE(flappybird::ParseSubmission("42 normal 3 40 10", parsed));
+  }
+  SECTION("Workers Verify Everything in the Queue") {
+    SubmissionQueue queue(4);
+    ScoreVerifier verifier(3);
+    std::atomic<size_t> accepted(0);
+    std::atomic<size_t> rejected(0);
+    std::thread producer([&queue, &honest] {
+        for (size_t i = 0; i < 20; i++) {
+            Submission submission = honest;
+            submission.claimed_score_ = i % 2 == 0 ? 4 : 5;
+            queue.Push(submission);
+        }
+        queue.Close();
+    });
+    verifier.Run(queue, [&accepted, &rejected](const Submission &, const Verdict &verdict) {
+        (verdict.accepted_ ? accepted : rejected)++;
+    });
+    producer.join();
+    REQUIRE(accepted == 10);
+    REQUIRE(rejected == 10);
+  }
+}
+
+// writes a course of identical pipes, one line of the text format per pipe
+static void WriteCourse(const string &path, size_t num_pipes, const string &pipe_line) {
+    flappybird::CourseWriter writer;
+    REQUIRE(writer.Open(path));
+    CoursePipe pipe;
+    REQUIRE(flappybird::ParseCoursePipe(pipe_line, pipe));
+    for (size_t i = 0; i < num_pipes; i++) {
+        REQUIRE(writer.Write(pipe));
+    }
+    REQUIRE(writer.Finish());
+}
+
+TEST_CASE("CourseFile") {
+    const string path = "flappy_bird_test_course.bin";
+    string error;
+  SECTION("Text Pipes Parse and Validate") {
+    CoursePipe pipe;
+    REQUIRE(flappybird::ParseCoursePipe("250 350 120 50 2.5 ff8800", pipe));
+    REQUIRE(pipe.spacing_ == 250);
+    REQUIRE(pipe.gap_bottom_ == 350);
+    REQUIRE(pipe.gap_size_ == 120);
+    REQUIRE(pipe.width_ == 50);
+    REQUIRE(pipe.speed_ == 2.5);
+    REQUIRE(pipe.color_ == 0xff8800);
+    REQUIRE(flappybird::ValidateCoursePipe(pipe, error));
+    REQUIRE_FALSE(flappybird::ParseCoursePipe("# a comment", pipe));
+    REQUIRE_FALSE(flappybird::ParseCoursePipe("250 350 120 50 2.5 ff8800 extra", pipe));
+    pipe.gap_bottom_ = 600;
+    REQUIRE_FALSE(flappybird::ValidateCoursePipe(pipe, error));
+  }
+  SECTION("Written Course Reads Back") {
+    WriteCourse(path, 1000, "250 350 120 50 2 ff8800");
+    CourseFile course;
+    REQUIRE(course.Open(path, error));
+    REQUIRE(course.GetPipeCount() == 1000);
+    for (size_t i = 0; i < course.GetPipeCount(); i++) {
+        REQUIRE(course.GetPipe(i).color_ == 0xff8800);
+        course.ReleaseBefore(i);
+    }
+    course.Close();
+    std::remove(path.c_str());
+  }
+  SECTION("Broken Files Are Refused") {
+    std::ofstream(path) << "not a course, but long enough to hold a header";
+    CourseFile course;
+    REQUIRE_FALSE(course.Open(path, error));
+    WriteCourse(path, 10, "250 350 120 50 2 ff8800");
+    std::ofstream(path, std::ios::app) << "x";
+    REQUIRE_FALSE(course.Open(path, error));
+    std::remove(path.c_str());
+  }
+  SECTION("Course Mode Plays the Authored Pipes to the End") {
+    WriteCourse(path, 10, "250 350 120 50 3 ff8800");
+    GameEngine game_engine;
+    REQUIRE(game_engine.LoadCourse(path, error));
+    SpectatorState state;
+    game_engine.HandleKeyPress(KeyEvent::KEY_SPACE);
+    for (size_t frame = 0; frame < 10000 && game_engine.GetGameState() == GameEngine::GameScreen; frame++) {
+        game_engine.WriteSpectatorState(state);
+        // the course starts with an empty window, so the bot holds the middle until a pipe shows up
+        float target_y = 300;
+        for (uint32_t i = 0; i < state.num_obstacles_; i++) {
+            if (state.obstacles_[i].x_ + 60 >= state.bird_x_) {
+                target_y = state.obstacles_[i].gap_bottom_ - 25;
+                break;
+            }
+        }
+        if (state.bird_y_ > target_y) {
+            game_engine.HandleKeyPress(KeyEvent::KEY_SPACE);
+        }
+        game_engine.AdvanceOneFrame();
+        vector<GameEngine::Obstacle> obstacles = game_engine.GetObstacles();
+        if (!obstacles.empty()) {
+            REQUIRE(obstacles[0].color_.r == 1);
+            REQUIRE(obstacles[0].upper_main_.getWidth() == 50);
+        }
+    }
+    REQUIRE(game_engine.GetGameState() == GameEngine::GameOverScreen);
+    REQUIRE(game_engine.GetScore() == 10);
+    REQUIRE_FALSE(game_engine.GetHasCollided());
+    // the game over screen after a finished course is no death
+    REQUIRE_FALSE(game_engine.HasDied());
+    std::remove(path.c_str());
+  }
+  SECTION("Broken Course Pipes End the Run When They Come Up") {
+    CoursePipe good;
+    REQUIRE(flappybird::ParseCoursePipe("250 350 120 50 2 ff8800", good));
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    for (std::pair<float, float> spacing_and_speed : {std::make_pair(250.0f, nan), std::make_pair(250.0f, 0.0f), 
+                                                      std::make_pair(250.0f, -2.0f), std::make_pair(nan, 2.0f),
+                                                      std::make_pair(0.0f, 2.0f), std::make_pair(-50.0f, 2.0f)}) {
+        flappybird::CourseWriter writer;
+        REQUIRE(writer.Open(path));
+        CoursePipe broken = good;
+        broken.spacing_ = spacing_and_speed.first;
+        broken.speed_ = spacing_and_speed.second;
+        REQUIRE(writer.Write(good));
+        REQUIRE(writer.Write(broken));
+        REQUIRE(writer.Write(good));
+        REQUIRE(writer.Finish());
+        // loading only looks at the header, the broken pipe is refused once the run gets to it
+        GameEngine game_engine;
+        REQUIRE(game_engine.LoadCourse(path, error));
+        game_engine.HandleKeyPress(KeyEvent::KEY_SPACE);
+        for (size_t frame = 0; frame < 1000 && game_engine.GetGameState() == GameEngine::GameScreen; frame++) {
+            if (game_engine.GetBird().position_.y >= 300) {
+                game_engine.HandleKeyPress(KeyEvent::KEY_SPACE);
+            }
+            game_engine.AdvanceOneFrame();
+        }
+        REQUIRE(game_engine.GetGameState() == GameEngine::GameOverScreen);
+        REQUIRE(game_engine.GetCourseError().find("pipe 1") != string::npos);
+        REQUIRE_FALSE(game_engine.HasDied());
+        REQUIRE(game_engine.GetGameMode() == GameEngine::Course);
+        // the next run starts over instead of carrying the error along
+        game_engine.StartRun(0, GameEngine::Course);
+        REQUIRE(game_engine.GetCourseError().empty());
+    }
+    std::remove(path.c_str());
+  }
+  SECTION("A Loaded Course Can Be Picked on the Start Screen") {
+    const vec2 course_button(500, 337);
+    GameEngine game_engine;
+    GameEngine::Snapshot snapshot;
+    game_engine.WriteSnapshot(snapshot);
+    REQUIRE_FALSE(snapshot.course_loaded_);
+    game_engine.HandleClick(course_button);
+    REQUIRE(game_engine.GetGameMode() == GameEngine::Normal);
+
+    WriteCourse(path, 10, "250 350 120 50 2 ff8800");
+    REQUIRE(game_engine.LoadCourse(path, error));
+    game_engine.HandleClick(vec2(500, 407));
+    REQUIRE(game_engine.GetGameMode() == GameEngine::Normal);
+    game_engine.HandleClick(course_button);
+    REQUIRE(game_engine.GetGameMode() == GameEngine::Course);
+    game_engine.WriteSnapshot(snapshot);
+    REQUIRE(snapshot.course_loaded_);
+    REQUIRE(snapshot.course_highlighted_);
+    REQUIRE_FALSE(snapshot.normal_highlighted_);
+    std::remove(path.c_str());
+  }
+  SECTION("Every Course Pipe Moves at Its Own Speed") {
+    flappybird::CourseWriter writer;
+    REQUIRE(writer.Open(path));
+    for (const char *line : {"50 350 120 50 2 ff8800", "100 350 120 50 4 ff8800", "100 350 120 50 1 ff8800"}) {
+        CoursePipe pipe;
+        REQUIRE(flappybird::ParseCoursePipe(line, pipe));
+        REQUIRE(writer.Write(pipe));
+    }
+    REQUIRE(writer.Finish());
+    GameEngine game_engine;
+    REQUIRE(game_engine.LoadCourse(path, error));
+    // hovering inside the gaps while all three pipes scroll in
+    for (size_t frame = 0; frame < 1000 && game_engine.GetObstacles().size() < 3; frame++) {
+        if (game_engine.GetBird().position_.y >= 300) {
+            game_engine.HandleKeyPress(KeyEvent::KEY_SPACE);
+        }
+        game_engine.AdvanceOneFrame();
+    }
+    REQUIRE_FALSE(game_engine.GetHasCollided());
+    vector<GameEngine::Obstacle> before = game_engine.GetObstacles();
+    game_engine.AdvanceOneFrame();
+    vector<GameEngine::Obstacle> after = game_engine.GetObstacles();
+    REQUIRE(after.size() == 3);
+    REQUIRE(before[0].upper_main_.getX1() - after[0].upper_main_.getX1() == 2);
+    REQUIRE(before[1].upper_main_.getX1() - after[1].upper_main_.getX1() == 4);
+    REQUIRE(before[2].upper_main_.getX1() - after[2].upper_main_.getX1() == 1);
+    std::remove(path.c_str());
+  }
+}
+
+TEST_CASE("SessionStats") {
+  SECTION("Tracker Reports Frame Time Percentiles and Tick Rate") {
+    SessionStatsTracker tracker;
+    // one tick a millisecond taking 1 to 1024 microseconds
+    for (uint64_t i = 1; i <= SessionStatsTracker::kFrameTimeSamples; i++) {
+        tracker.RecordTick(i * 1000, i, false);
+    }
+    SessionStats stats;
+    tracker.Fill(stats);
+    REQUIRE(stats.frame_time_p50_us_ == 512);
+    REQUIRE(stats.frame_time_p90_us_ == 921);
+    REQUIRE(stats.frame_time_p99_us_ == 1013);
+    REQUIRE(stats.frame_time_max_us_ == 1024);
+    REQUIRE(stats.ticks_per_second_ == Approx(1000));
+  }
+  SECTION("Tracker Counts Deaths Over the Last Minute") {
+    SessionStatsTracker tracker;
+    SessionStats stats;
+    // a death every ten seconds, the game over screen is held for one second each time
+    for (uint64_t second = 0; second < 120; second++) {
+        tracker.RecordTick(second * 1000000, 1, second % 10 == 0);
+    }
+    tracker.Fill(stats);
+    REQUIRE(stats.deaths_ == 12);
+    REQUIRE(stats.deaths_per_minute_ == 6);
+    tracker.RecordTick(300 * 1000000ull, 1, false);
+    tracker.Fill(stats);
+    REQUIRE(stats.deaths_ == 12);
+    REQUIRE(stats.deaths_per_minute_ == 0);
+  }
+  SECTION("A Death Counts Once Until the Next Run") {
+    SessionStatsTracker tracker;
+    SessionStats stats;
+    GameEngine game_engine;
+    uint64_t now_us = 0;
+    game_engine.HandleKeyPress(KeyEvent::KEY_SPACE);
+    for (size_t tick = 0; tick < 1000; tick++) {
+        game_engine.AdvanceOneFrame();
+        tracker.RecordTick(now_us += 16667, 1, game_engine.HasDied());
+    }
+    REQUIRE(game_engine.GetGameState() == GameEngine::GameOverScreen);
+    tracker.Fill(stats);
+    REQUIRE(stats.deaths_ == 1);
+    // back on the start screen the run is over, the next death is a new one
+    game_engine.HandleKeyPress(KeyEvent::KEY_SPACE);
+    REQUIRE_FALSE(game_engine.HasDied());
+    tracker.RecordTick(now_us += 16667, 1, game_engine.HasDied());
+    game_engine.HandleKeyPress(KeyEvent::KEY_SPACE);
+    while (game_engine.GetGameState() == GameEngine::GameScreen) {
+        game_engine.AdvanceOneFrame();
+        tracker.RecordTick(now_us += 16667, 1, game_engine.HasDied());
+    }
+    tracker.Fill(stats);
+    REQUIRE(stats.deaths_ == 2);
+  }
+#if defined(__linux__)
+  SECTION("Readers Only See Whole Updates") {
+    string name = flappybird::StatsSegmentName(flappybird::CurrentProcessId()) + "-test";
+    StatsPublisher publisher;
+    REQUIRE(publisher.Open(name));
+    StatsReader reader;
+    REQUIRE(reader.Open(name));
+    SessionStats stats;
+    REQUIRE(reader.Read(stats));
+    REQUIRE(stats.tick_ == 0);
+
+    // every word of an update holds the same value, so a torn read would show mismatched words
+    // the writer keeps publishing until the reader got enough reads in between its updates, so the test can't pass
+    // without the two ever overlapping, not even when the threads share one core
+    const size_t kMinReadsWhileWriting = 1000;
+    std::atomic<bool> writing(true);
+    std::atomic<size_t> reads_while_writing(0);
+    std::atomic<uint32_t> num_published(0);
+    std::thread writer([&publisher, &writing, &reads_while_writing, &num_published, kMinReadsWhileWriting] {
+        SessionStats update;
+        uint32_t i = 0;
+        while (i < 200000 || (reads_while_writing < kMinReadsWhileWriting && i < 100000000)) {
+            i++;
+            update.pid_ = update.tick_ = update.score_ = update.deaths_ = i;
+            update.frame_time_max_us_ = i;
+            publisher.Publish(update);
+        }
+        num_published = i;
+        writing = false;
+    });
+    size_t num_reads = 0;
+    bool consistent = true;
+    while (writing) {
+        if (reader.Read(stats)) {
+            consistent = consistent && stats.pid_ == stats.tick_ && stats.tick_ == stats.score_ && 
+                         stats.score_ == stats.deaths_ && stats.frame_time_max_us_ == stats.deaths_;
+            num_reads++;
+            // started after the first update and done before the last one
+            if (stats.tick_ > 0 && writing) {
+                reads_while_writing++;
+            }
+        }
+    }
+    writer.join();
+    REQUIRE(consistent);
+    REQUIRE(num_reads > 0);
+    REQUIRE(reads_while_writing >= kMinReadsWhileWriting);
+    REQUIRE(reader.Read(stats));
+    REQUIRE(stats.tick_ == num_published);
+    publisher.Close();
+    StatsReader closed_reader;
+    REQUIRE_FALSE(closed_reader.Open(name));
+  }
+#endif
+  SECTION("Engine Fills the Game Fields") {
+    GameEngine game_engine;
+    game_engine.StartRun(1, GameEngine::Normal);
+    game_engine.AdvanceOneFrame();
+    SessionStats stats;
+    game_engine.WriteSessionStats(stats);
+    REQUIRE(stats.game_state_ == GameEngine::GameScreen);
+    REQUIRE(stats.game_mode_ == GameEngine::Normal);
+    REQUIRE(stats.obstacle_count_ == 2);
+  }
+}
+
+TEST_CASE("AssetPack") {
+    const string path = "flappy_bird_test_assets.pack";
+    string error;
+    // a font whose only drawn glyph is 'A', two texels wide with a coverage of 200 at the second texel
+    vector<BakedGlyph> glyphs(flappybird::kLastBakedChar - flappybird::kFirstBakedChar + 1, BakedGlyph());
+    glyphs['A' - flappybird::kFirstBakedChar] = {1, 0, 2, 1, 3};
+    vector<uint8_t> atlas = {0, 0, 200, 0};
+  SECTION("Written Pack Reads Back in Place") {
+    AssetPackWriter writer;
+    writer.AddFont("Times New Roman", 20, 15, glyphs, 4, 1, atlas);
+    writer.AddFont("Times New Roman", 40, 30, glyphs, 4, 1, atlas);
+    REQUIRE(writer.Write(path));
+    AssetPack pack;
+    REQUIRE(pack.Open(path, error));
+    REQUIRE(pack.FindFont("Times New Roman", 30) == nullptr);
+    REQUIRE(pack.FindFont("Arial", 40) == nullptr);
+    const BakedFont *font = pack.FindFont("Times New Roman", 40);
+    REQUIRE(font != nullptr);
+    REQUIRE(font->baseline_offset_ == 30);
+    const BakedGlyph *glyph = pack.GetGlyph(*font, 'A');
+    REQUIRE(glyph != nullptr);
+    REQUIRE(glyph->advance_ == 3);
+    REQUIRE(pack.GetGlyph(*font, '\n') == nullptr);
+    REQUIRE(pack.GetAtlas(*font)[2] == 200);
+    REQUIRE(reinterpret_cast<uintptr_t>(pack.GetAtlas(*font)) % flappybird::kAssetAlignment == 0);
+    pack.Close();
+    std::remove(path.c_str());
+  }
+  SECTION("Baked Reachability Tables Are Handed to Get") {
+    // physics no other test uses, so the table only exists in the pack when it is loaded
+    GameEngine game_engine;
+    FlightPhysics physics = game_engine.GetFlightPhysics(GameEngine::Challenge);
+    physics.gap_size_ -= 2;
+    ReachabilityTable built(physics);
+    AssetPackWriter writer;
+    writer.AddFont("Times New Roman", 20, 15, glyphs, 4, 1, atlas);
+    built.Bake(writer);
+    REQUIRE(writer.Write(path));
+    AssetPack pack;
+    REQUIRE(pack.Open(path, error));
+    REQUIRE(pack.GetReachabilityCount() == 1);
+    REQUIRE(reinterpret_cast<uintptr_t>(pack.GetReachableBits(pack.GetReachability(0))) % 8 == 0);
+    REQUIRE(ReachabilityTable::LoadBaked(pack) == 1);
+    REQUIRE(ReachabilityTable::LoadBaked(pack) == 0);
+    pack.Close();
+    std::remove(path.c_str());
+
+    const ReachabilityTable &loaded = ReachabilityTable::Get(physics);
+    REQUIRE(loaded.GetUnusedTransitions() == built.GetUnusedTransitions());
+    bool same = true;
+    for (int from = physics.min_gap_bottom_; from <= physics.max_gap_bottom_; from++) {
+        same = same && loaded.GetMinNext(from) == built.GetMinNext(from) &&
+               loaded.GetMaxNext(from) == built.GetMaxNext(from);
+        for (int to = physics.min_gap_bottom_; to <= physics.max_gap_bottom_; to++) {
+            same = same && loaded.IsReachable(from, to) == built.IsReachable(from, to);
+        }
+    }
+    REQUIRE(same);
+  }
+  SECTION("Broken Packs Are Refused") {
+    std::ofstream(path) << "not an asset pack, but long enough to hold a header";
+    AssetPack pack;
+    REQUIRE_FALSE(pack.Open(path, error));
+    AssetPackWriter writer;
+    writer.AddFont("Times New Roman", 20, 15, glyphs, 4, 1, atlas);
+    REQUIRE(writer.Write(path));
+    // cutting the pixels off leaves the font pointing past the end of the file
+    std::ifstream input(path, std::ios::binary);
+    string bytes((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    input.close();
+    std::ofstream(path, std::ios::binary) << bytes.substr(0, bytes.size() - 2);
+    REQUIRE_FALSE(pack.Open(path, error));
+    REQUIRE_FALSE(pack.IsOpen());
+    std::remove(path.c_str());
+  }
+  SECTION("Engine Lists Every Font Size It Draws With") {
+    GameEngine game_engine;
+    vector<float> sizes = game_engine.GetFontSizes();
+    REQUIRE(game_engine.GetFontName() == "Times New Roman");
+    REQUIRE(std::is_sorted(sizes.begin(), sizes.end()));
+    REQUIRE(std::adjacent_find(sizes.begin(), sizes.end()) == sizes.end());
+    REQUIRE(std::find(sizes.begin(), sizes.end(), 40) != sizes.end());
+    REQUIRE(std::find(sizes.begin(), sizes.end(), 20) != sizes.end());
+  }
+}
+
+// follows gaps for a fixed number of ticks and then stops flapping, so every bot eventually lands
+class QuittingBot : public flappybird::BirdController {
+  public:
+    QuittingBot(float margin, size_t ticks) : follower_(margin), ticks_left_(ticks) {
+    }
+    bool ShouldFlap(const flappybird::BirdObservation &observation) override {
+        if (ticks_left_ == 0) {
+            return false;
+        }
+        ticks_left_--;
+        return follower_.ShouldFlap(observation);
+    }
+
+  private:
+    flappybird::GapFollower follower_;
+    size_t ticks_left_;
+};
+
+TEST_CASE("Flock") {
+  SECTION("A Flock Bird Flies Exactly Like the Single Bird") {
+    for (GameEngine::GameMode game_mode : {GameEngine::Normal, GameEngine::PipeStorm}) {
+        GameEngine single;
+        GameEngine flock;
+        flock.AddFlockBird(KeyEvent::KEY_SPACE, nullptr, Color("yellow"));
+        single.StartRun(7, game_mode);
+        flock.StartRun(7, game_mode);
+        // both engines get the flaps the bot picks for the single bird, it stops flapping after three points
+        SpectatorState state;
+        for (size_t frame = 0; frame < 100000 && single.GetGameState() == GameEngine::GameScreen; frame++) {
+            single.WriteSpectatorState(state);
+            bool flap = frame == 0;
+            for (uint32_t i = 0; i < state.num_obstacles_ && state.score_ < 3; i++) {
+                if (state.obstacles_[i].x_ + 60 >= state.bird_x_) {
+                    flap = state.bird_y_ > state.obstacles_[i].gap_bottom_ - 25;
+                    break;
+                }
+            }
+            if (flap) {
+                single.HandleKeyPress(KeyEvent::KEY_SPACE);
+                flock.HandleKeyPress(KeyEvent::KEY_SPACE);
+            }
+            single.AdvanceOneFrame();
+            flock.AdvanceOneFrame();
+            REQUIRE(flock.GetFlock().GetY()[0] == single.GetBird().position_.y);
+            REQUIRE(flock.GetScore() == single.GetScore());
+            REQUIRE(flock.GetGameState() == single.GetGameState());
+        }
+        REQUIRE(single.GetGameState() == GameEngine::GameOverScreen);
+        REQUIRE((game_mode == GameEngine::PipeStorm || single.GetScore() == 3));
+    }
+  }
+  SECTION("Keys Only Flap Their Own Bird") {
+    GameEngine game_engine;
+    game_engine.AddFlockBird(KeyEvent::KEY_SPACE, nullptr, Color("yellow"));
+    game_engine.AddFlockBird(KeyEvent::KEY_UP, nullptr, Color("red"));
+    game_engine.StartRun(1, GameEngine::Normal);
+    game_engine.HandleKeyPress(KeyEvent::KEY_UP);
+    game_engine.AdvanceOneFrame();
+    REQUIRE(game_engine.GetFlock().GetY()[0] == 300);
+    REQUIRE(game_engine.GetFlock().GetY()[1] < 300);
+    REQUIRE(game_engine.GetFlock().GetFlyingCount() == 1);
+  }
+  SECTION("Bots Race Until the Last One Lands") {
+    GameEngine game_engine;
+    const size_t kBots = 1000;
+    for (size_t i = 0; i < kBots; i++) {
+        game_engine.AddFlockBird(flappybird::Flock::kNoKey, 
+                                 std::make_shared<QuittingBot>(5 + 40.0f * i / kBots, 300 + i), Color("white"));
+    }
+    game_engine.StartRun(3, GameEngine::Normal);
+    const flappybird::Flock &flock = game_engine.GetFlock();
+    size_t frame = 0;
+    bool scrolled_after_first_death = false;
+    for (; frame < 100000 && game_engine.GetGameState() == GameEngine::GameScreen; frame++) {
+        size_t obstacle_count = game_engine.GetObstacles().size();
+        float first_x = obstacle_count > 0 ? game_engine.GetObstacles()[0].upper_main_.getX1() : 0;
+        game_engine.AdvanceOneFrame();
+        if (flock.GetAliveCount() < kBots && flock.GetAliveCount() > 0 && obstacle_count > 0 && 
+            game_engine.GetObstacles()[0].upper_main_.getX1() < first_x) {
+            scrolled_after_first_death = true;
+        }
+    }
+    REQUIRE(game_engine.GetGameState() == GameEngine::GameOverScreen);
+    REQUIRE(scrolled_after_first_death);
+    REQUIRE(flock.GetLandedCount() == kBots);
+    REQUIRE(game_engine.GetScore() == flock.GetBestScore());
+    REQUIRE(flock.GetBestScore() > *std::min_element(flock.GetScores(), flock.GetScores() + kBots));
+    game_engine.HandleKeyPress(KeyEvent::KEY_SPACE);
+    REQUIRE(flock.GetAliveCount() == kBots);
+    REQUIRE(flock.GetBestScore() == 0);
+  }
+}
+
+TEST_CASE("Reachability") {
+    GameEngine engine;
+    const ReachabilityTable &normal = ReachabilityTable::Get(engine.GetFlightPhysics(GameEngine::Normal));
+    const ReachabilityTable &challenge = ReachabilityTable::Get(engine.GetFlightPhysics(GameEngine::Challenge));
+  SECTION("Tables Are Built Once per Physics") {
+    REQUIRE(&ReachabilityTable::Get(engine.GetFlightPhysics(GameEngine::Normal)) == &normal);
+    REQUIRE(&normal != &challenge);
+  }
+  SECTION("Threads Asking for a Table Being Built Get the Same One") {
+    // physics no other test uses, so both threads ask while the table is still missing
+    FlightPhysics physics = engine.GetFlightPhysics(GameEngine::Normal);
+    physics.gap_size_ -= 1;
+    const ReachabilityTable *first = nullptr;
+    const ReachabilityTable *second = nullptr;
+    std::thread builder([&physics, &first] {
+        first = &ReachabilityTable::Get(physics);
+    });
+    second = &ReachabilityTable::Get(physics);
+    builder.join();
+    REQUIRE(first == second);
+    REQUIRE(first->GetPhysics().gap_size_ == physics.gap_size_);
+  }
+  SECTION("Staying Level Is Always Reachable and Spawn Ranges Have No Holes") {
+    for (const ReachabilityTable *table : {&normal, &challenge}) {
+        const FlightPhysics &physics = table->GetPhysics();
+        for (int from = physics.min_gap_bottom_; from <= physics.max_gap_bottom_; from++) {
+            REQUIRE(table->IsReachable(from, from));
+            REQUIRE(table->GetMinNext(from) <= from);
+            REQUIRE(table->GetMaxNext(from) >= from);
+            for (int to = table->GetMinNext(from); to <= table->GetMaxNext(from); to++) {
+                REQUIRE(table->IsReachable(from, to));
+            }
+        }
+    }
+  }
+  SECTION("Challenge Birds Can't Climb from the Lowest Gap to the Highest") {
+    const FlightPhysics &physics = challenge.GetPhysics();
+    REQUIRE(normal.IsReachable(physics.max_gap_bottom_, physics.min_gap_bottom_));
+    REQUIRE_FALSE(challenge.IsReachable(physics.max_gap_bottom_, physics.min_gap_bottom_));
+    // dropping is always easier than climbing
+    REQUIRE(challenge.IsReachable(physics.min_gap_bottom_, physics.max_gap_bottom_));
+  }
+  SECTION("The First Gap Is Drawn Like Before") {
+    std::mt19937 picked(5);
+    std::mt19937 uniform(5);
+    for (size_t i = 0; i < 100; i++) {
+        REQUIRE(PickGapBottom(nullptr, 0, 138, 353, picked) == uniform() % 353 + 138.0f);
+    }
+  }
+  SECTION("Every Picked Gap Is Reachable from the One Before") {
+    std::mt19937 random(9);
+    float gap_bottom = 502;
+    bool climbed_far = false;
+    for (size_t i = 0; i < 100000; i++) {
+        float next = PickGapBottom(&challenge, gap_bottom, 150, 353, random);
+        REQUIRE(next >= 150);
+        REQUIRE(next <= 502);
+        REQUIRE(challenge.IsReachable(static_cast<int>(gap_bottom), static_cast<int>(next)));
+        climbed_far = climbed_far || gap_bottom - next > 150;
+        gap_bottom = next;
+    }
+    REQUIRE(climbed_far);
+  }
+  SECTION("Challenge Runs Only Spawn Reachable Gaps") {
+    GameEngine game_engine;
+    for (size_t i = 0; i < 100; i++) {
+        game_engine.AddFlockBird(flappybird::Flock::kNoKey, std::make_shared<flappybird::GapFollower>(5 + 0.4f * i), 
+                                 Color("white"));
+    }
+    size_t pairs_checked = 0;
+    for (unsigned seed = 0; seed < 20; seed++) {
+        game_engine.StartRun(seed, GameEngine::Challenge);
+        for (size_t frame = 0; frame < 5000 && game_engine.GetGameState() == GameEngine::GameScreen; frame++) {
+            game_engine.AdvanceOneFrame();
+            vector<GameEngine::Obstacle> obstacles = game_engine.GetObstacles();
+            for (size_t i = 0; i + 1 < obstacles.size(); i++) {
+                REQUIRE(challenge.IsReachable(static_cast<int>(obstacles[i].lower_main_.getY1()), 
+                                              static_cast<int>(obstacles[i + 1].lower_main_.getY1())));
+                pairs_checked++;
+            }
+        }
+    }
+    REQUIRE(pairs_checked > 0);
+  }
+}